@@ -0,0 +1,18 @@
+// alloc.h : allocation of the big buffers (grids, render points, tables)
+
+#pragma once
+
+#include <cstddef>
+
+// every buffer starts on a cache line boundary
+constexpr size_t BUFFER_ALIGNMENT = 64;
+
+// buffers at least this big are backed by huge pages when the system allows it
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+extern bool useHugePages;
+
+void* Allocate_Buffer(size_t, const char*);
+void Free_Buffer(void*);
+size_t Reserved_Bytes();
+void Log_Allocations();
@@ -0,0 +1,79 @@
+// bits.h : bit tricks shared by the kernels that pack cells into words, or find live cells in bytes
+
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// the number of set bits in a word
+inline int Count_Bits(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (int)__popcnt64(word);
+#elif defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (int)((word * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// the position of the lowest set bit of a non-zero word
+inline int Lowest_Bit(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#elif defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int index = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// adds up three words bit by bit, into a sum bit and a carry bit
+inline void Full_Add(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry)
+{
+    const uint64_t partial = a ^ b;
+    sum = partial ^ c;
+    carry = (a & b) | (partial & c);
+}
+
+// the SplitMix64 finalizer, which scrambles a word so that every bit of it depends on every bit
+// that went in
+inline uint64_t Mix_Bits(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// calls visit(i) for every cell i from 0 to count - 1 that's alive, where cells are bytes holding
+// 0 or 1. they're found 8 at a time: each live cell is a set bit in the lowest bit of its byte
+template <typename Visit>
+inline void For_Each_Live_Byte(const void* cells, int count, Visit visit)
+{
+    const Uint8* bytes = (const Uint8*)cells;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint64_t eight;
+        SDL_memcpy(&eight, bytes + i, sizeof(eight));
+        for (; eight != 0; eight &= eight - 1) visit(i + Lowest_Bit(eight) / 8);
+    }
+    for (; i < count; i++) {
+        if (bytes[i]) visit(i);
+    }
+}
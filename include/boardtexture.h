@@ -0,0 +1,9 @@
+// boardtexture.h : draws the board through a texture that only has the tiles that changed uploaded
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Board_Texture_Render(SDL_Renderer*, const SDL_FPoint*, int);
+void Board_Texture_Release();
+void Board_Texture_Log_Stats();
@@ -0,0 +1,65 @@
+// bounds.h : boxes on the board that wrap around its edges, for keeping track of where live cells are
+
+#pragma once
+
+#include "cells.h"
+
+// `length` cells going right (or down) from `start`, wrapping around after the last one.
+// a length of 0 is nothing, and a length of the whole board is everything
+struct Span {
+    int start;
+    int length;
+};
+
+struct Box {
+    Span x;
+    Span y;
+};
+
+// the shortest span covering both spans, on a board `size` cells across. it has to start where
+// one of them does, so it's whichever of the two ways round is shorter
+inline Span Span_Union(Span a, Span b, int size) {
+    if (a.length == 0) return b;
+    if (b.length == 0) return a;
+
+    const int fromA = SDL_max(a.length, (b.start - a.start + size) % size + b.length);
+    const int fromB = SDL_max(b.length, (a.start - b.start + size) % size + a.length);
+
+    const Span span = (fromA <= fromB) ? Span{ a.start, fromA } : Span{ b.start, fromB };
+    return (span.length >= size) ? Span{ 0, size } : span;
+}
+
+// the span with `margin` more cells on each end
+inline Span Span_Grow(Span span, int margin, int size) {
+    if (span.length == 0) return span;
+    if (span.length + 2 * margin >= size) return { 0, size };
+    return { (span.start - margin + size) % size, span.length + 2 * margin };
+}
+
+inline bool Box_Is_Empty(Box box) {
+    return box.x.length == 0 || box.y.length == 0;
+}
+
+inline Box Empty_Box() {
+    return { { 0, 0 }, { 0, 0 } };
+}
+
+inline Box Whole_Board() {
+    return { { 0, simWidth }, { 0, simHeight } };
+}
+
+// the smallest box covering both boxes
+inline Box Box_Union(Box a, Box b) {
+    if (Box_Is_Empty(a)) return b;
+    if (Box_Is_Empty(b)) return a;
+    return { Span_Union(a.x, b.x, simWidth), Span_Union(a.y, b.y, simHeight) };
+}
+
+inline Box Box_Grow(Box box, int margin) {
+    if (Box_Is_Empty(box)) return box;
+    return { Span_Grow(box.x, margin, simWidth), Span_Grow(box.y, margin, simHeight) };
+}
+
+inline Box Box_Add_Point(Box box, int x, int y) {
+    return Box_Union(box, { { x, 1 }, { y, 1 } });
+}
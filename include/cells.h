@@ -4,7 +4,24 @@
 #pragma once
 
 // TODO: Reference additional headers your program requires here.
+#include <SDL3/SDL.h>
 
+// the width and height of the simulation, set at startup
+extern int simWidth;
+extern int simHeight;
+
+
+bool Parse_Arguments(int, char* []);
+bool Allocate_Grid();
+void Randomize_Grid(float);
+double Cell_Updates_Per_Step();
+SDL_AppResult Run_Headless_Step();
+SDL_AppResult Run_Replay_Frame();
+Uint64 Hash_Bytes(const void*, size_t);
+Uint64 Grid_Hash();
+void Clear_Grid();
+bool Run_Render_Bench(int);
+void Render_Frame();
 
 void PaintCells();
 void Paint_Line(int, int, int, int);
@@ -13,8 +30,17 @@ void Paint_Line_Shallow(int, int, int, int, int, int);
 bool Try_Paint_Point(int, int);
 
 void Update_Simulation();
+void Update_Simulation_Dense();
+void Update_Simulation_Dense_Morton();
+void Step_Back();
+void Choose_Engine();
 void Add_Rendered_Point(int, int);
 void Clear_Rendered_Points();
+void Request_Redraw();
 
-
+const bool* Grid_Cells();
+bool Get_Cell(int, int);
+void Set_Cell(int, int, bool);
+void Set_Next_Cell(int, int, bool);
+void Swap_States();
 
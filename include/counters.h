@@ -0,0 +1,8 @@
+// counters.h : hardware performance counters around each step, on every worker thread
+
+#pragma once
+
+bool Counters_Setup(int);
+void Counters_Begin(int);
+void Counters_End(int);
+void Counters_Log_Stats(double);
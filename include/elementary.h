@@ -0,0 +1,14 @@
+// elementary.h : one-dimensional elementary cellular automata (Wolfram rules 0 to 255)
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Parse_Elementary_Rule(const char*);
+bool Elementary_Setup();
+void Elementary_Randomize(float, Uint64);
+void Elementary_Paint(int, int);
+void Elementary_Update_Simulation();
+int Elementary_Population();
+Uint64 Elementary_Hash();
+void Elementary_Render(SDL_Renderer*);
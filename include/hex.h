@@ -0,0 +1,14 @@
+// hex.h : life on a hexagonal grid, bit-packed in offset rows
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Parse_Hex_Rule(const char*);
+bool Hex_Setup();
+void Hex_Randomize(float, Uint64);
+void Hex_Paint(int, int);
+void Hex_Update_Simulation();
+int Hex_Population();
+Uint64 Hex_Hash();
+void Hex_Render(SDL_Renderer*);
@@ -0,0 +1,20 @@
+// jit.h : compiles rule tables into native x86-64 step kernels at runtime
+
+#pragma once
+
+#include <cstdint>
+
+// one call of a compiled kernel: `bytes` cells (a multiple of 16, at least 16) down a column,
+// written to output. the cells just above the first and just below the last are read as neighbors
+struct JitColumn {
+    const bool* left;
+    const bool* column;
+    const bool* right;
+    bool* output;
+    intptr_t bytes;
+};
+
+typedef void (*JitKernel)(const JitColumn*);
+
+JitKernel Jit_Compile_Rule(const char*, const uint8_t*);
+void Jit_Release();
@@ -0,0 +1,82 @@
+// layout.h : how the cells of the grid are arranged in memory
+//
+// everything that reads or writes the grid finds a cell through Cell_Index, so the layout can be
+// changed at startup without touching the code that paints, steps or renders the board.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "cells.h"
+
+enum class GridLayout {
+    Linear, // one column after another, like a bool[simWidth][simHeight] array
+    Morton, // square tiles the size of a cache line, with the tiles in Z-order
+    RowMajor // one row after another, gridStride cells apart, in the same order as the framebuffer
+};
+
+// the width and height of a morton tile. one tile of bytes fills exactly one 64-byte cache line
+constexpr int MORTON_TILE_SIZE = 8;
+constexpr int MORTON_TILE_CELLS = MORTON_TILE_SIZE * MORTON_TILE_SIZE;
+
+extern GridLayout gridLayout;
+
+// the distance between the starts of two rows in the row-major layout. it's at least simWidth,
+// and the cells past the end of a row are padding that stays dead
+extern int gridStride;
+
+// the number of bits in the x and y tile coordinates of the morton layout
+extern int mortonBitsX;
+extern int mortonBitsY;
+
+void Setup_Layout(GridLayout, int);
+size_t Grid_Cell_Count();
+size_t Morton_Tile_Count();
+bool Morton_Tile_Position(size_t, int*, int*);
+
+// spreads the bits of v out so there is a zero between each of them (abcd -> 0a0b0c0d)
+inline uint64_t Spread_Bits(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2)) & 0x3333333333333333ull;
+    x = (x | (x << 1)) & 0x5555555555555555ull;
+    return x;
+}
+
+// the position of a tile in Z-order. the bits of the two coordinates are interleaved for as long
+// as both have bits, then the extra bits of the longer side go on top. that way a tall or wide
+// board is a column or row of square Z-ordered blocks, rather than being padded out to a square
+inline size_t Morton_Tile_Index(int tx, int ty) {
+    const int shared = mortonBitsX < mortonBitsY ? mortonBitsX : mortonBitsY;
+    const uint32_t sharedMask = (uint32_t)((1ull << shared) - 1);
+
+    const uint64_t low = Spread_Bits((uint32_t)tx & sharedMask) | (Spread_Bits((uint32_t)ty & sharedMask) << 1);
+    const uint64_t high = (mortonBitsX > mortonBitsY) ? (uint64_t)tx >> shared : (uint64_t)ty >> shared;
+
+    return (size_t)(low | (high << (2 * shared)));
+}
+
+// the index of a cell in the linear layout
+inline size_t Linear_Index(int x, int y) {
+    return (size_t)x * simHeight + y;
+}
+
+// the index of a cell in the row-major layout
+inline size_t Row_Major_Index(int x, int y) {
+    return (size_t)y * gridStride + x;
+}
+
+// the index of a cell in the morton layout. inside a tile, cells go column by column
+inline size_t Morton_Index(int x, int y) {
+    return Morton_Tile_Index(x / MORTON_TILE_SIZE, y / MORTON_TILE_SIZE) * MORTON_TILE_CELLS
+        + (x % MORTON_TILE_SIZE) * MORTON_TILE_SIZE + (y % MORTON_TILE_SIZE);
+}
+
+// the index of a cell in whichever layout is in use
+inline size_t Cell_Index(int x, int y) {
+    if (gridLayout == GridLayout::Morton) return Morton_Index(x, y);
+    if (gridLayout == GridLayout::RowMajor) return Row_Major_Index(x, y);
+    return Linear_Index(x, y);
+}
@@ -0,0 +1,14 @@
+// lenia.h : a continuous cellular automaton (Lenia) stepped with FFT convolution
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Parse_Lenia_Parameters(const char*);
+bool Lenia_Setup();
+void Lenia_Randomize(float, Uint64);
+void Lenia_Paint(int, int);
+void Lenia_Update_Simulation();
+int Lenia_Population();
+Uint64 Lenia_Hash();
+void Lenia_Render(SDL_Renderer*);
@@ -0,0 +1,15 @@
+// life3d.h : 3D outer-totalistic cellular automata on a bit-packed toroidal volume
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Parse_Life3D_Rule(const char*);
+bool Life3D_Setup(int);
+void Life3D_Randomize(float, Uint64);
+void Life3D_Paint(int, int);
+void Life3D_Update_Simulation();
+int Life3D_Population();
+Uint64 Life3D_Hash();
+void Life3D_Change_Slice(int);
+void Life3D_Toggle_Projection();
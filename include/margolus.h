@@ -0,0 +1,8 @@
+// margolus.h : block cellular automata on the Margolus neighborhood (alternating 2x2 blocks)
+
+#pragma once
+
+bool Parse_Margolus_Rule(const char*);
+bool Margolus_Is_Reversible();
+int Margolus_Update_Simulation(bool*);
+int Margolus_Step_Back(bool*);
@@ -0,0 +1,9 @@
+// metrics.h : prometheus metrics for long runs, written to a file for node-exporter to pick up
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+void Metrics_Start(const char*, int, int);
+void Metrics_Record_Step(Uint64, int);
+void Metrics_Stop();
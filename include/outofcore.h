@@ -0,0 +1,5 @@
+// outofcore.h : steps boards that are too big to fit in memory, straight from disk
+
+#pragma once
+
+bool Out_Of_Core_Run(const char*, const char*, int);
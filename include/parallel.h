@@ -0,0 +1,10 @@
+// parallel.h : a dense engine that splits each step into tile tasks for the work-stealing scheduler
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+void Parallel_Setup();
+void Parallel_Invalidate();
+void Parallel_Mark_Changed(int, int);
+int Parallel_Update_Simulation(const bool*, bool*, SDL_FPoint*);
@@ -0,0 +1,20 @@
+// replay.h : recording the input events of a session, and replaying them headless step for step
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Record_Start(const char*, Uint64, int, int, char* []);
+void Record_Event(const SDL_Event*);
+void Record_Mod_State(SDL_Keymod);
+void Record_Step();
+void Record_End_Frame();
+void Record_Stop(Uint64, int);
+
+bool Replay_Load(const char*, Uint64*, int*, int*, int*);
+char** Replay_Arguments(int*);
+bool Replay_Next_Event(SDL_Event*);
+SDL_Keymod Replay_Mod_State();
+bool Replay_Step();
+bool Replay_End_Frame();
+bool Replay_Expected(Uint64*, int*);
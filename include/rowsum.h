@@ -0,0 +1,5 @@
+// rowsum.h : a dense kernel that counts neighbors as separable 3-cell sums
+
+#pragma once
+
+int Update_Simulation_Row_Sum(const bool*, bool*);
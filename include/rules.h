@@ -0,0 +1,11 @@
+// rules.h : rules other than Conway's, compiled to a lookup table over the 3x3 neighborhood,
+// optionally with births and survivals that only happen some of the time
+
+#pragma once
+
+bool Parse_Rule(const char*);
+bool Rule_Is_Life();
+bool Parse_Rule_Probabilities(const char*);
+bool Rule_Compile();
+void Seed_Rule_Random(Uint64);
+int Update_Simulation_Rule(const bool*, bool*, SDL_FPoint*);
@@ -0,0 +1,13 @@
+// scheduler.h : a work-stealing thread pool for splitting a pass over the board into tasks
+
+#pragma once
+
+// runs task number `task` of a pass on worker number `worker` (0 is the thread that called
+// Scheduler_Run). context is whatever was passed to Scheduler_Run
+typedef void (*TaskFunction)(int task, int worker, void* context);
+
+bool Scheduler_Start(int);
+void Scheduler_Stop();
+void Scheduler_Run(int, TaskFunction, void*);
+int Scheduler_Worker_Count();
+void Scheduler_Log_Stats();
@@ -0,0 +1,8 @@
+// sparse.h : the live-cell-list engine, used when the board is almost empty
+
+#pragma once
+
+void Sparse_Load_From_Grid();
+void Sparse_Add_Cell(int, int);
+void Sparse_Update_Simulation();
+int Sparse_Population();
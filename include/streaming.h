@@ -0,0 +1,8 @@
+// streaming.h : a dense kernel that writes the next generation with non-temporal stores
+
+#pragma once
+
+// how far ahead (in cache lines) the streaming kernel prefetches, by default
+constexpr int DEFAULT_PREFETCH_DISTANCE = 8;
+
+int Update_Simulation_Streaming(const bool*, bool*, int);
@@ -0,0 +1,8 @@
+// tilememo.h : an engine that remembers the results of tiles it has seen before
+
+#pragma once
+
+bool Tile_Memo_Allocate();
+void Tile_Memo_Update_Simulation();
+int Tile_Memo_Population();
+void Tile_Memo_Log_Stats();
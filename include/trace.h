@@ -0,0 +1,27 @@
+// trace.h : timed spans of each part of a frame, written out as a chrome trace
+//
+// a TraceSpan records from where it's declared to the end of its scope. when tracing is off the
+// only cost is checking traceEnabled, so the spans are left in all the time.
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+extern bool traceEnabled;
+
+void Trace_Setup(const char*, int);
+void Trace_Toggle();
+void Trace_Add(const char*, int, Uint64, Uint64);
+void Trace_Write();
+
+struct TraceSpan {
+    const char* name;
+    int worker;
+    Uint64 start;
+
+    // name has to be a string that lives forever, like a literal
+    TraceSpan(const char* name, int worker = 0) : name(name), worker(worker), start(traceEnabled ? SDL_GetPerformanceCounter() : 0) {}
+    ~TraceSpan() {
+        if (start != 0 && traceEnabled) Trace_Add(name, worker, start, SDL_GetPerformanceCounter());
+    }
+};
@@ -0,0 +1,13 @@
+// wireworld.h : an event-driven Wireworld engine that only visits electrons
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+bool Wireworld_Allocate();
+bool Wireworld_Load(const char*);
+void Wireworld_Paint(int, int, bool);
+void Wireworld_Update_Simulation();
+int Wireworld_Population();
+Uint64 Wireworld_Hash();
+void Wireworld_Render(SDL_Renderer*);
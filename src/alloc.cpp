@@ -0,0 +1,189 @@
+// allocation of the big buffers
+//
+// on a 16k x 16k board each grid is 256 MB, and with 4 KB pages just walking it blows through the
+// TLB. buffers of 2 MB or more are put on 2 MB huge pages when possible:
+//   - linux: explicit huge pages (MAP_HUGETLB) if some are reserved, otherwise a 2 MB aligned
+//     mapping marked with madvise(MADV_HUGEPAGE) so transparent huge pages can back it
+//   - windows: large pages (MEM_LARGE_PAGES), which needs the "lock pages in memory" privilege,
+//     otherwise a normal VirtualAlloc
+// anything that doesn't work falls back to the next option, down to a plain aligned allocation.
+// every buffer is zeroed and at least cache line aligned.
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include "alloc.h"
+
+// whether big buffers should try to use huge pages at all
+bool useHugePages = true;
+
+// how a buffer's memory was obtained
+enum class PageKind {
+    Aligned, // SDL_aligned_alloc, regular pages
+    Mapped, // a page mapping, regular pages
+    TransparentHuge, // a 2 MB aligned mapping, marked for transparent huge pages
+    ExplicitHuge // reserved huge pages (MAP_HUGETLB / MEM_LARGE_PAGES)
+};
+
+struct Allocation {
+    void* pointer;
+    size_t bytes; // what was asked for
+    size_t mappedBytes; // what was actually reserved
+    PageKind kind;
+    const char* name;
+};
+
+static std::vector<Allocation> allocations;
+
+// the total of every live buffer's mappedBytes, which other threads can read at any time
+static std::atomic<size_t> reservedBytes{ 0 };
+
+static const char* Page_Kind_Name(PageKind kind) {
+    switch (kind) {
+    case PageKind::Aligned: return "regular pages";
+    case PageKind::Mapped: return "regular pages, mapped";
+    case PageKind::TransparentHuge: return "transparent huge pages";
+    case PageKind::ExplicitHuge: return "huge pages";
+    }
+    return "";
+}
+
+static size_t Round_Up(size_t bytes, size_t multiple) {
+    return (bytes + multiple - 1) / multiple * multiple;
+}
+
+// tries to get a huge page backed mapping (or at least a page mapping), filling in the allocation
+// if it worked. page mappings always come back zeroed
+static bool Try_Huge_Pages(size_t bytes, Allocation& allocation) {
+#ifdef _WIN32
+    const size_t largePage = GetLargePageMinimum();
+    if (largePage != 0) {
+        const size_t length = Round_Up(bytes, largePage);
+        void* pointer = VirtualAlloc(NULL, length, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (pointer != NULL) {
+            allocation = { pointer, bytes, length, PageKind::ExplicitHuge, NULL };
+            return true;
+        }
+    }
+
+    const size_t length = Round_Up(bytes, 64 << 10);
+    void* pointer = VirtualAlloc(NULL, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (pointer != NULL) {
+        allocation = { pointer, bytes, length, PageKind::Mapped, NULL };
+        return true;
+    }
+    return false;
+#elif defined(__linux__)
+    const size_t length = Round_Up(bytes, HUGE_PAGE_SIZE);
+
+#ifdef MAP_HUGETLB
+    void* pointer = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (pointer != MAP_FAILED) {
+        allocation = { pointer, bytes, length, PageKind::ExplicitHuge, NULL };
+        return true;
+    }
+#endif
+
+    // no reserved huge pages, so map an extra huge page's worth and trim it down to a 2 MB
+    // aligned range. transparent huge pages can only back 2 MB aligned memory
+    char* raw = (char*)mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == (char*)MAP_FAILED) return false;
+
+    char* aligned = (char*)Round_Up((size_t)raw, HUGE_PAGE_SIZE);
+    if (aligned > raw) munmap(raw, (size_t)(aligned - raw));
+    munmap(aligned + length, (size_t)(raw + HUGE_PAGE_SIZE - aligned));
+
+    PageKind kind = PageKind::Mapped;
+#ifdef MADV_HUGEPAGE
+    if (madvise(aligned, length, MADV_HUGEPAGE) == 0) kind = PageKind::TransparentHuge;
+#endif
+    allocation = { aligned, bytes, length, kind, NULL };
+    return true;
+#else
+    (void)bytes;
+    (void)allocation;
+    return false;
+#endif
+}
+
+// allocates a zeroed, cache line aligned buffer, on huge pages if it's big enough
+// name is only used for the allocation report, and has to stay valid
+void* Allocate_Buffer(size_t bytes, const char* name) {
+    Allocation allocation = {};
+    if (bytes == 0) bytes = 1;
+
+    if (!(useHugePages && bytes >= HUGE_PAGE_SIZE && Try_Huge_Pages(bytes, allocation))) {
+        const size_t length = Round_Up(bytes, BUFFER_ALIGNMENT);
+        void* pointer = SDL_aligned_alloc(BUFFER_ALIGNMENT, length);
+        if (pointer == NULL) {
+            SDL_Log("Couldn't allocate %llu bytes for %s", (unsigned long long)bytes, name);
+            return NULL;
+        }
+        std::memset(pointer, 0, length);
+        allocation = { pointer, bytes, length, PageKind::Aligned, NULL };
+    }
+
+    allocation.name = name;
+    allocations.push_back(allocation);
+    reservedBytes.fetch_add(allocation.mappedBytes, std::memory_order_relaxed);
+    return allocation.pointer;
+}
+
+// releases a buffer from Allocate_Buffer
+void Free_Buffer(void* pointer) {
+    for (size_t i = 0; i < allocations.size(); i++) {
+        const Allocation& allocation = allocations[i];
+        if (allocation.pointer != pointer) continue;
+
+        if (allocation.kind == PageKind::Aligned) SDL_aligned_free(pointer);
+#ifdef _WIN32
+        else VirtualFree(pointer, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        else munmap(pointer, allocation.mappedBytes);
+#endif
+        reservedBytes.fetch_sub(allocation.mappedBytes, std::memory_order_relaxed);
+        allocations.erase(allocations.begin() + i);
+        return;
+    }
+}
+
+// the memory reserved for all the live buffers, from any thread
+size_t Reserved_Bytes() {
+    return reservedBytes.load(std::memory_order_relaxed);
+}
+
+// reports every live buffer and how it's backed
+void Log_Allocations() {
+    size_t total = 0;
+    size_t huge = 0;
+
+    for (const Allocation& allocation : allocations) {
+        SDL_Log("  %-16s %10.2f MB  %s", allocation.name, allocation.bytes / (1024.0 * 1024.0), Page_Kind_Name(allocation.kind));
+        total += allocation.mappedBytes;
+        if (allocation.kind == PageKind::TransparentHuge || allocation.kind == PageKind::ExplicitHuge) huge += allocation.mappedBytes;
+    }
+    SDL_Log("  %.2f MB reserved in %d buffers, %.2f MB of it on huge pages",
+        total / (1024.0 * 1024.0), (int)allocations.size(), huge / (1024.0 * 1024.0));
+
+#if defined(__linux__)
+    // transparent huge pages only get used if the system allows it
+    SDL_IOStream* setting = SDL_IOFromFile("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (setting != NULL) {
+        char text[128] = {};
+        SDL_ReadIO(setting, text, sizeof(text) - 1);
+        SDL_CloseIO(setting);
+
+        char* newline = SDL_strchr(text, '\n');
+        if (newline != NULL) *newline = '\0';
+        SDL_Log("  transparent huge pages: %s", text);
+    }
+#endif
+}
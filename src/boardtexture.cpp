@@ -0,0 +1,232 @@
+// draws the board through a texture that stays on the gpu between frames, so each frame only
+// uploads the parts of the board that changed since the last one
+//
+// the board is split into DIRTY_TILE_SIZE square tiles. every engine already reports its live cells
+// in the render buffer, so each frame those are summed into a signature for each tile, and a tile
+// whose signature isn't the one it had when it was last uploaded has had a birth or a death in it.
+// the dirty tiles are joined into rectangles (runs along each row of tiles, carried down while the
+// rows below have a run with the same ends), then the pair of rectangles that wastes the least area
+// is merged until there are at most MAX_DIRTY_RECTS. a busy board costs a few large uploads rather
+// than hundreds of small ones, and a quiet one costs almost nothing.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "bits.h"
+#include "boardtexture.h"
+#include "cells.h"
+#include "layout.h"
+#include "trace.h"
+
+constexpr int DIRTY_TILE_SHIFT = 5;
+constexpr int DIRTY_TILE_SIZE = 1 << DIRTY_TILE_SHIFT;
+constexpr int DIRTY_TILE_MASK = DIRTY_TILE_SIZE - 1;
+
+// the most SDL_UpdateTexture calls in a frame
+constexpr int MAX_DIRTY_RECTS = 16;
+
+constexpr Uint32 LIVE_PIXEL = 0xFFFFFFFF;
+constexpr Uint32 DEAD_PIXEL = 0xFF000000;
+
+static SDL_Texture* texture = NULL;
+static bool textureFailed = false; // the board is too big for a texture, so it's drawn as points
+static bool wholeBoardDirty = true; // nothing has been uploaded yet
+
+static int tilesX = 0;
+static int tilesY = 0;
+
+// a random value for each cell position within a tile. a tile's signature is the sum of the values
+// of its live cells, so it doesn't matter what order the engine found them in
+static uint64_t cellValues[DIRTY_TILE_SIZE * DIRTY_TILE_SIZE];
+
+// the signature of each tile as it is in the texture, and as it is on the board now
+static std::vector<uint64_t> shownSignatures;
+static std::vector<uint64_t> signatures;
+
+// the rectangles of tiles to upload this frame, the ones that end on the row of tiles before the
+// one being scanned (which runs on that row can carry down), and the pixels of one rectangle
+static std::vector<SDL_Rect> dirtyRects;
+static std::vector<size_t> openAbove;
+static std::vector<size_t> openHere;
+static std::vector<Uint32> pixels;
+
+// what's been uploaded, for the stats
+static uint64_t framesDrawn = 0;
+static uint64_t rectsUploaded = 0;
+static uint64_t bytesUploaded = 0;
+
+static bool Create_Texture(SDL_Renderer* renderer)
+{
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, simWidth, simHeight);
+    if (texture == NULL) {
+        SDL_Log("Couldn't create a texture for the board, drawing it as points instead: %s", SDL_GetError());
+        textureFailed = true;
+        return false;
+    }
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+
+    tilesX = (simWidth + DIRTY_TILE_MASK) >> DIRTY_TILE_SHIFT;
+    tilesY = (simHeight + DIRTY_TILE_MASK) >> DIRTY_TILE_SHIFT;
+    shownSignatures.assign((size_t)tilesX * tilesY, 0);
+    signatures.assign((size_t)tilesX * tilesY, 0);
+
+    for (int i = 0; i < DIRTY_TILE_SIZE * DIRTY_TILE_SIZE; i++) cellValues[i] = Mix_Bits((uint64_t)i + 1);
+    return true;
+}
+
+static bool Tile_Is_Dirty(int tx, int ty)
+{
+    const size_t tile = (size_t)ty * tilesX + tx;
+    return wholeBoardDirty || signatures[tile] != shownSignatures[tile];
+}
+
+static int Rect_Area(const SDL_Rect& rect)
+{
+    return rect.w * rect.h;
+}
+
+// finds the rectangles of tiles that changed since the last frame, and counts the board as uploaded
+static void Find_Dirty_Rects(const SDL_FPoint* points, int pointCount)
+{
+    std::fill(signatures.begin(), signatures.end(), 0);
+    for (int p = 0; p < pointCount; p++) {
+        const int x = (int)points[p].x;
+        const int y = (int)points[p].y;
+        const size_t tile = (size_t)(y >> DIRTY_TILE_SHIFT) * tilesX + (x >> DIRTY_TILE_SHIFT);
+        signatures[tile] += cellValues[((y & DIRTY_TILE_MASK) << DIRTY_TILE_SHIFT) | (x & DIRTY_TILE_MASK)];
+    }
+
+    dirtyRects.clear();
+    openAbove.clear();
+
+    for (int ty = 0; ty < tilesY; ty++) {
+        openHere.clear();
+        size_t above = 0; // runs come left to right, and so do the rectangles open above them
+
+        for (int tx = 0; tx < tilesX; tx++) {
+            if (!Tile_Is_Dirty(tx, ty)) continue;
+
+            const int start = tx;
+            while (tx + 1 < tilesX && Tile_Is_Dirty(tx + 1, ty)) tx++;
+            const int width = tx - start + 1;
+
+            while (above < openAbove.size() && dirtyRects[openAbove[above]].x < start) above++;
+            if (above < openAbove.size() && dirtyRects[openAbove[above]].x == start && dirtyRects[openAbove[above]].w == width) {
+                dirtyRects[openAbove[above]].h++;
+                openHere.push_back(openAbove[above]);
+            }
+            else {
+                openHere.push_back(dirtyRects.size());
+                dirtyRects.push_back({ start, ty, width, 1 });
+            }
+        }
+
+        std::swap(openAbove, openHere);
+    }
+
+    std::swap(signatures, shownSignatures);
+    wholeBoardDirty = false;
+
+    // a scattered board can have thousands of rectangles, so they're first folded into bands of
+    // the ones next to each other in the list (which are close together, since they were found
+    // top to bottom), to keep the search for the best pair to merge short
+    const size_t foldLimit = 4 * MAX_DIRTY_RECTS;
+    if (dirtyRects.size() > foldLimit) {
+        const size_t group = (dirtyRects.size() + foldLimit - 1) / foldLimit;
+        size_t folded = 0;
+        for (size_t r = 0; r < dirtyRects.size(); r += group) {
+            SDL_Rect band = dirtyRects[r];
+            for (size_t g = r + 1; g < r + group && g < dirtyRects.size(); g++) SDL_GetRectUnion(&band, &dirtyRects[g], &band);
+            dirtyRects[folded++] = band;
+        }
+        dirtyRects.resize(folded);
+    }
+
+    while (dirtyRects.size() > (size_t)MAX_DIRTY_RECTS) {
+        size_t bestA = 0, bestB = 1;
+        int bestWaste = INT32_MAX;
+
+        for (size_t a = 0; a < dirtyRects.size(); a++) {
+            for (size_t b = a + 1; b < dirtyRects.size(); b++) {
+                SDL_Rect merged;
+                SDL_GetRectUnion(&dirtyRects[a], &dirtyRects[b], &merged);
+                const int waste = Rect_Area(merged) - Rect_Area(dirtyRects[a]) - Rect_Area(dirtyRects[b]);
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+
+        SDL_GetRectUnion(&dirtyRects[bestA], &dirtyRects[bestB], &dirtyRects[bestA]);
+        dirtyRects.erase(dirtyRects.begin() + bestB);
+    }
+}
+
+// copies a rectangle of tiles from the grid into the texture
+static void Upload_Rect(const SDL_Rect& tiles)
+{
+    const int x = tiles.x << DIRTY_TILE_SHIFT;
+    const int y = tiles.y << DIRTY_TILE_SHIFT;
+    const SDL_Rect cells = { x, y, SDL_min(tiles.w << DIRTY_TILE_SHIFT, simWidth - x), SDL_min(tiles.h << DIRTY_TILE_SHIFT, simHeight - y) };
+
+    pixels.resize((size_t)cells.w * cells.h);
+    for (int j = 0; j < cells.h; j++) {
+        Uint32* row = pixels.data() + (size_t)j * cells.w;
+
+        // the row-major layout is already in the texture's order, so each row is one straight run
+        if (gridLayout == GridLayout::RowMajor) {
+            const bool* source = Grid_Cells() + Row_Major_Index(x, y + j);
+            for (int i = 0; i < cells.w; i++) row[i] = source[i] ? LIVE_PIXEL : DEAD_PIXEL;
+        }
+        else {
+            for (int i = 0; i < cells.w; i++) row[i] = Get_Cell(x + i, y + j) ? LIVE_PIXEL : DEAD_PIXEL;
+        }
+    }
+
+    SDL_UpdateTexture(texture, &cells, pixels.data(), cells.w * (int)sizeof(Uint32));
+    rectsUploaded++;
+    bytesUploaded += pixels.size() * sizeof(Uint32);
+}
+
+// brings the texture up to date with the live cells in the render buffer, and draws it
+// returns false if there's no texture, and the points need drawing some other way
+bool Board_Texture_Render(SDL_Renderer* renderer, const SDL_FPoint* points, int pointCount)
+{
+    if (textureFailed) return false;
+    if (texture == NULL && !Create_Texture(renderer)) return false;
+
+    {
+        TraceSpan span("upload dirty tiles");
+        Find_Dirty_Rects(points, pointCount);
+        for (const SDL_Rect& tiles : dirtyRects) Upload_Rect(tiles);
+    }
+    framesDrawn++;
+
+    const SDL_FRect destination = { 0, 0, (float)simWidth, (float)simHeight };
+    SDL_RenderTexture(renderer, texture, NULL, &destination);
+    return true;
+}
+
+// destroys the texture, which has to happen before its renderer goes. the next frame makes a new one
+void Board_Texture_Release()
+{
+    if (texture != NULL) SDL_DestroyTexture(texture);
+    texture = NULL;
+    textureFailed = false;
+    wholeBoardDirty = true;
+}
+
+// logs how much of the board had to be uploaded each frame
+void Board_Texture_Log_Stats()
+{
+    if (framesDrawn == 0) return;
+
+    const double wholeBoard = (double)simWidth * simHeight * sizeof(Uint32);
+    const double perFrame = (double)bytesUploaded / (double)framesDrawn;
+    SDL_Log("board texture: %llu frames, %.1f rects and %.1f KB uploaded per frame (%.1f%% of the board)",
+        (unsigned long long)framesDrawn, (double)rectsUploaded / (double)framesDrawn,
+        perFrame / 1024.0, 100.0 * perFrame / wholeBoard);
+}
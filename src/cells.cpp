@@ -8,20 +8,70 @@
 #include <SDL3/SDL_main.h>
 #include <cmath>
 #include <algorithm>
+#include <vector>
 #include "cells.h"
+#include "sparse.h"
+#include "outofcore.h"
+#include "tilememo.h"
+#include "layout.h"
+#include "boardtexture.h"
+#include "counters.h"
+#include "trace.h"
+#include "metrics.h"
+#include "replay.h"
+#include "bounds.h"
+#include "alloc.h"
+#include "streaming.h"
+#include "rowsum.h"
+#include "scheduler.h"
+#include "parallel.h"
+#include "rules.h"
+#include "jit.h"
+#include "margolus.h"
+#include "wireworld.h"
+#include "lenia.h"
+#include "life3d.h"
+#include "hex.h"
+#include "elementary.h"
+
+// the default width and height of the simulation
+constexpr int DEFAULT_SIM_WIDTH = 480;
+constexpr int DEFAULT_SIM_HEIGHT = 270;
+
+// the largest number of pixels per simulation cell
+constexpr int MAX_RENDER_SCALE = 4;
+
+// the largest the window can get, in pixels. bigger boards are drawn at a smaller scale,
+// and if even one pixel per cell doesn't fit, only the top-left of the board is shown
+constexpr int MAX_WINDOW_WIDTH = 1920;
+constexpr int MAX_WINDOW_HEIGHT = 1080;
 
-// the width and height of the simulation
-constexpr int SIM_WIDTH = 480;
-constexpr int SIM_HEIGHT = 270;
+constexpr int MAX_STEPS_PER_SECOND = 20; //maximum number of simulation steps per second
 
-// the number of pixels per simulation cell
-constexpr int RENDER_SCALE = 4;
+// --threads is capped at this many threads per logical core; past that the workers only take
+// turns, and far past it the system runs out of threads to give
+constexpr int MAX_THREADS_PER_CORE = 4;
 
-// the width and height of the window in pixels
-constexpr int WINDOW_WIDTH = SIM_WIDTH * RENDER_SCALE;
-constexpr int WINDOW_HEIGHT = SIM_HEIGHT * RENDER_SCALE;
+// the most slices a 3D board can have, and the most memory each of its two volumes can take
+constexpr int MAX_VOLUME_DEPTH = 4096;
+constexpr Uint64 MAX_VOLUME_BYTES = 4ull << 30;
 
-constexpr int MAX_STEPS_PER_SECOND = 20; //maximum number of simulation steps per second
+// the densities and render scales the render bench tries
+static const float RENDER_BENCH_DENSITIES[] = { 0.01f, 0.05f, 0.1f, 0.2f, 0.35f, 0.5f };
+static const int RENDER_BENCH_SCALES[] = { 1, 2, 4 };
+
+// the simulation switches to the sparse engine when the fraction of live cells drops below
+// SPARSE_ENTER_DENSITY, and back to the dense engine when it rises above SPARSE_EXIT_DENSITY.
+// the gap between the two keeps a board near the threshold from switching every step
+constexpr double SPARSE_ENTER_DENSITY = 0.01;
+constexpr double SPARSE_EXIT_DENSITY = 0.04;
+
+// the width and height of the simulation
+int simWidth = DEFAULT_SIM_WIDTH;
+int simHeight = DEFAULT_SIM_HEIGHT;
+
+// the number of pixels per simulation cell
+static int renderScale = MAX_RENDER_SCALE;
 
 //the window and renderer
 static SDL_Window* window = NULL;
@@ -43,12 +93,21 @@ static int lastMouseCellY;
 // if the left mouse button was down last frame
 static bool mouseWasDown = false;
 
+// if shift is held down, which paints electrons instead of copper in Wireworld
+static bool paintingElectrons = false;
+
 // the current and next state of the simulation
-static bool currentState[SIM_WIDTH][SIM_HEIGHT];
-static bool nextState[SIM_WIDTH][SIM_HEIGHT];
+// cells are found with Cell_Index, which depends on the grid layout
+static bool* currentState = NULL;
+static bool* nextState = NULL;
+
+// boxes that every live cell of currentState, and of nextState, is inside. Update_Simulation_Dense
+// only steps the cells near them, and the other engines just set them to the whole board
+static Box liveBox = Empty_Box();
+static Box staleBox = Empty_Box();
 
 // a buffer of points to render
-static SDL_FPoint renderPoints[SIM_WIDTH * SIM_HEIGHT];
+static SDL_FPoint* renderPoints = NULL;
 
 // the number of points in the render buffer that should be rendered.
 static int renderPointCount = 0;
@@ -56,31 +115,518 @@ static int renderPointCount = 0;
 // whether the screen needs to be redrawn
 static bool needs_new_render = true;
 
+// the number of live cells on the board
+static int population = 0;
+
+// the engines that can step the simulation
+enum class StepEngine {
+    Dense, // checks every cell
+    Sparse, // only visits live cells, for nearly empty boards
+    TileMemo, // looks up 16x16 tiles it has seen before, for boards full of ash
+    Margolus, // a block cellular automaton instead of life, set with --margolus
+    Wireworld, // Wireworld instead of life, only visiting the electrons
+    Lenia, // a continuous cellular automaton instead of life, set with --lenia
+    Life3D, // life in a 3D volume, set with --life3d
+    Hex, // life on a hexagonal grid, set with --hex
+    Elementary // a one-dimensional automaton like rule 110, set with --elementary
+};
+
+// the engine stepping the simulation right now
+static StepEngine currentEngine = StepEngine::Dense;
+
+// whether to switch between the dense and sparse engines based on density
+static bool autoSwitchEngine = true;
+
+// the kernels the dense engine can use on the linear layout
+enum class DenseKernel {
+    Simple, // Update_Simulation_Dense
+    Streaming, // SIMD with non-temporal stores and prefetching, for boards much bigger than the cache
+    RowSum, // neighbors counted as vertical then horizontal 3-cell sums
+    Compiled // the rule compiled to native code at startup
+};
+
+static DenseKernel denseKernel = DenseKernel::Simple;
+
+// how 2D boards get drawn
+enum class RenderPath {
+    Points, // every live cell passed to SDL_RenderPoints
+    Texture // a texture that only has the tiles that changed uploaded to it
+};
+
+static RenderPath renderPath = RenderPath::Texture;
+
+// how many cache lines ahead the streaming kernel prefetches
+static int prefetchDistance = DEFAULT_PREFETCH_DISTANCE;
+
+// how many threads step the board. with more than one, the dense engine on the linear layout
+// splits each step into tiles for the work-stealing scheduler
+static int threadCount = 1;
+
+// command line options
+static const char* outOfCoreInput = NULL; // if set, step this file instead of opening a window
+static const char* outOfCoreOutput = NULL;
+static int generationsToRun = 1; // how many generations headless runs should step
+static bool headless = false; // step as fast as possible without a window, then report timings
+static int renderBenchFrames = 0; // if above 0, time this many frames of each render bench setup, then quit
+static bool useCounters = false; // read the hardware performance counters around each step
+static const char* traceFile = NULL; // if set, record a trace of every frame from the start
+static const char* metricsFile = NULL; // if set, write prometheus metrics here every metricsInterval seconds
+static int metricsInterval = 10;
+static const char* recordFile = NULL; // if set, write the input events of the session here
+static const char* replayFile = NULL; // if set, replay the input events in this file headless instead of opening a window
+static bool replayOptionsGiven = false; // if options that change the run were given alongside --replay, replacing the recorded ones
+static bool boardOptionsParsed = false; // if Parse_Arguments saw an option that changes the run, rather than just watching it
+static float randomDensity = 0; // if above 0, start with this fraction of cells alive
+static Uint64 randomSeed = 1;
+static GridLayout requestedLayout = GridLayout::Linear;
+static int requestedStride = 0; // the row stride of the row-major layout, or 0 to pick one
+static const char* wireworldPattern = NULL; // an RLE file to load into Wireworld
+static int volumeDepth = 64; // how many slices 3D boards have
+
+// headless run progress
+static int generationsRun = 0;
+static Uint64 headlessStepTicks = 0; // performance counter ticks spent in Update_Simulation
+static int replayStepsRun = 0;
+
 // runs on startup
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
 {
     SDL_SetAppMetadata("Game of Life", "1.0", NULL);
 
+    if (!Parse_Arguments(argc, argv)) return SDL_APP_FAILURE;
+
+    // replays start from the seed, board size, render scale and options they were recorded with, and
+    // don't need a window. options given again on the command line win over the recorded ones
+    if (replayFile != NULL) {
+        if (!Replay_Load(replayFile, &randomSeed, &simWidth, &simHeight, &renderScale)) return SDL_APP_FAILURE;
+
+        int recordedCount = 0;
+        char** recorded = Replay_Arguments(&recordedCount);
+        if (!Parse_Arguments(recordedCount, recorded)) return SDL_APP_FAILURE;
+        boardOptionsParsed = false;
+        if (!Parse_Arguments(argc, argv)) return SDL_APP_FAILURE;
+        replayOptionsGiven = boardOptionsParsed;
+        headless = true;
+    }
+    else if (recordFile != NULL && headless) {
+        SDL_Log("Recording needs a window to take input from");
+        return SDL_APP_FAILURE;
+    }
+
+    // out-of-core runs work straight from disk and never open a window
+    if (outOfCoreInput != NULL) {
+        return Out_Of_Core_Run(outOfCoreInput, outOfCoreOutput, generationsToRun) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    // the other engines and layouts only know Conway's rules
+    if (!Rule_Is_Life()) {
+        if (currentEngine != StepEngine::Dense || requestedLayout != GridLayout::Linear) {
+            SDL_Log("Rules other than B3/S23 (and stochastic rules) need the dense engine and the linear layout");
+            return SDL_APP_FAILURE;
+        }
+        autoSwitchEngine = false;
+    }
+
+    // compiled kernels step through the rule kernel, whatever the rule
+    if (denseKernel == DenseKernel::Compiled) {
+        if (currentEngine != StepEngine::Dense || requestedLayout != GridLayout::Linear) {
+            SDL_Log("The jit kernel needs the dense engine and the linear layout");
+            return SDL_APP_FAILURE;
+        }
+        if (!Rule_Compile()) denseKernel = DenseKernel::Simple;
+        autoSwitchEngine = false;
+    }
+
+    // the threaded and streaming kernels only step the linear layout, and Morton order only has the
+    // simple kernel. the sparse engine counts here too, since it hands busy boards to the dense one
+    if (currentEngine == StepEngine::Dense || currentEngine == StepEngine::Sparse) {
+        if (requestedLayout != GridLayout::Linear && (threadCount > 1 || denseKernel == DenseKernel::Streaming)) {
+            SDL_Log("--threads and the stream kernel need the linear layout");
+            return SDL_APP_FAILURE;
+        }
+        if (requestedLayout == GridLayout::Morton && denseKernel == DenseKernel::RowSum) {
+            SDL_Log("The rowsum kernel needs the linear or rows layout");
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    // 3D boards keep two volumes of a bit per cell. the depth is compared against how many slices
+    // fit, rather than multiplying it out, so a huge board can't overflow past the check
+    if (currentEngine == StepEngine::Life3D) {
+        const Uint64 sliceBytes = (Uint64)(simWidth / 64) * simHeight * sizeof(Uint64);
+        if (sliceBytes > 0 && (Uint64)volumeDepth > MAX_VOLUME_BYTES / sliceBytes) {
+            SDL_Log("A %dx%dx%d board is too big; each volume can take at most %d MB",
+                simWidth, simHeight, volumeDepth, (int)(MAX_VOLUME_BYTES >> 20));
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    // the render bench refills the dense grid for every setup, so it sticks to the dense engine
+    if (renderBenchFrames > 0) {
+        if (currentEngine != StepEngine::Dense) {
+            SDL_Log("The render bench needs the dense engine");
+            return SDL_APP_FAILURE;
+        }
+        autoSwitchEngine = false;
+    }
+
+    // the 2x2 blocks have to tile the board exactly, including where it wraps around
+    if (currentEngine == StepEngine::Margolus && (simWidth % 2 != 0 || simHeight % 2 != 0)) {
+        SDL_Log("Block rules need a board with an even width and height");
+        return SDL_APP_FAILURE;
+    }
+
+    if (requestedStride != 0 && requestedStride < simWidth) {
+        SDL_Log("The stride has to be at least the width of the board (%d)", simWidth);
+        return SDL_APP_FAILURE;
+    }
+
+    Setup_Layout(requestedLayout, requestedStride);
+    if (!Allocate_Grid()) return SDL_APP_FAILURE;
+    Seed_Rule_Random(randomSeed);
+
+    // painting draws from SDL's random numbers too (Lenia's blobs), so they're seeded even without
+    // --random, and a recording paints the same values when it's replayed
+    SDL_srand(randomSeed);
+    if (useCounters && !Counters_Setup(threadCount)) useCounters = false;
+    Trace_Setup(traceFile, threadCount);
+    if (metricsFile != NULL) Metrics_Start(metricsFile, metricsInterval, simWidth * simHeight);
+    if (threadCount > 1) {
+        if (!Scheduler_Start(threadCount)) return SDL_APP_FAILURE;
+        Parallel_Setup();
+    }
+
+    // lenia keeps its own field of values from 0 to 1, which it transforms on all the threads
+    if (currentEngine == StepEngine::Lenia) {
+        if (!Lenia_Setup()) return SDL_APP_FAILURE;
+        if (randomDensity > 0) Lenia_Randomize(randomDensity, randomSeed);
+    }
+
+    // so does 3D life, as bit-packed slices
+    if (currentEngine == StepEngine::Life3D) {
+        if (!Life3D_Setup(volumeDepth)) return SDL_APP_FAILURE;
+        if (randomDensity > 0) Life3D_Randomize(randomDensity, randomSeed);
+    }
+
+    // and hex life, as bit-packed rows
+    if (currentEngine == StepEngine::Hex) {
+        if (!Hex_Setup()) return SDL_APP_FAILURE;
+        if (randomDensity > 0) Hex_Randomize(randomDensity, randomSeed);
+    }
+
+    // and 1D automata, as a bit-packed history of rows. without a random start they grow from one cell
+    if (currentEngine == StepEngine::Elementary) {
+        if (!Elementary_Setup()) return SDL_APP_FAILURE;
+        if (randomDensity > 0) Elementary_Randomize(randomDensity, randomSeed);
+        else Elementary_Paint(simWidth / 2, 0);
+    }
+    if (wireworldPattern != NULL && !Wireworld_Load(wireworldPattern)) return SDL_APP_FAILURE;
+    const bool ownGrid = currentEngine == StepEngine::Lenia || currentEngine == StepEngine::Life3D || currentEngine == StepEngine::Hex
+        || currentEngine == StepEngine::Elementary;
+    if (randomDensity > 0 && !ownGrid) Randomize_Grid(randomDensity);
+
+    SDL_Log("buffers for a %dx%d board:", simWidth, simHeight);
+    Log_Allocations();
+
+    if (renderBenchFrames > 0) return Run_Render_Bench(renderBenchFrames) ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+
+    // headless runs just step the board in SDL_AppIterate
+    if (headless) return SDL_APP_CONTINUE;
+
     if (!SDL_Init(SDL_INIT_VIDEO)) {
         SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    if (!SDL_CreateWindowAndRenderer("cells", WINDOW_WIDTH, WINDOW_HEIGHT, 0, &window, &renderer)) {
+    // use the biggest scale that fits the whole board on screen
+    renderScale = MAX_RENDER_SCALE;
+    while (renderScale > 1 && (simWidth * renderScale > MAX_WINDOW_WIDTH || simHeight * renderScale > MAX_WINDOW_HEIGHT)) {
+        renderScale--;
+    }
+    const int windowWidth = SDL_min(simWidth * renderScale, MAX_WINDOW_WIDTH);
+    const int windowHeight = SDL_min(simHeight * renderScale, MAX_WINDOW_HEIGHT);
+
+    if (!SDL_CreateWindowAndRenderer("cells", windowWidth, windowHeight, 0, &window, &renderer)) {
         SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
 
-    SDL_SetRenderScale(renderer, RENDER_SCALE, RENDER_SCALE);
+    SDL_SetRenderScale(renderer, (float)renderScale, (float)renderScale);
+
+    if (recordFile != NULL && !Record_Start(recordFile, randomSeed, renderScale, argc, argv)) return SDL_APP_FAILURE;
 
     last_step_time = SDL_GetTicks();
 
     return SDL_APP_CONTINUE;
 }
 
+// reads the command line options
+// returns false (after logging why) if they don't make sense
+bool Parse_Arguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++) {
+
+        // options that only record or replay the run, or measure it, don't change where it ends up
+        const char* option = argv[i];
+        if (SDL_strcmp(option, "--replay") != 0 && SDL_strcmp(option, "--record") != 0 && SDL_strcmp(option, "--trace") != 0
+            && SDL_strcmp(option, "--counters") != 0 && SDL_strcmp(option, "--metrics") != 0
+            && SDL_strcmp(option, "--metrics-interval") != 0 && SDL_strcmp(option, "--headless") != 0) {
+            boardOptionsParsed = true;
+        }
+
+        // --out-of-core <input.pbm> <output.pbm> steps a board stored on disk
+        if (SDL_strcmp(argv[i], "--out-of-core") == 0 && i + 2 < argc) {
+            outOfCoreInput = argv[i + 1];
+            outOfCoreOutput = argv[i + 2];
+            i += 2;
+        }
+
+        // --engine <auto|dense|sparse|memo|wireworld> picks how the simulation is stepped
+        // auto switches between dense and sparse as the density changes, the others stick
+        // (wireworld runs Wireworld instead of life)
+        else if (SDL_strcmp(argv[i], "--engine") == 0 && i + 1 < argc) {
+            const char* name = argv[i + 1];
+            autoSwitchEngine = false;
+
+            if (SDL_strcmp(name, "auto") == 0) {
+                currentEngine = StepEngine::Dense;
+                autoSwitchEngine = true;
+            }
+            else if (SDL_strcmp(name, "dense") == 0) currentEngine = StepEngine::Dense;
+            else if (SDL_strcmp(name, "sparse") == 0) currentEngine = StepEngine::Sparse;
+            else if (SDL_strcmp(name, "memo") == 0) currentEngine = StepEngine::TileMemo;
+            else if (SDL_strcmp(name, "wireworld") == 0) currentEngine = StepEngine::Wireworld;
+            else {
+                SDL_Log("Unknown engine: %s", name);
+                return false;
+            }
+            i++;
+        }
+
+        // --rule <rule> steps a different rule, in Hensel notation (e.g. B2n3/S23-q) or as a MAP string
+        else if (SDL_strcmp(argv[i], "--rule") == 0 && i + 1 < argc) {
+            if (!Parse_Rule(argv[i + 1])) return false;
+            i++;
+        }
+
+        // --stochastic <birth>,<survival> makes births and survivals only happen with those probabilities
+        else if (SDL_strcmp(argv[i], "--stochastic") == 0 && i + 1 < argc) {
+            if (!Parse_Rule_Probabilities(argv[i + 1])) return false;
+            i++;
+        }
+
+        // --margolus <rule> runs a block cellular automaton instead of life, e.g. bbm or critters
+        else if (SDL_strcmp(argv[i], "--margolus") == 0 && i + 1 < argc) {
+            if (!Parse_Margolus_Rule(argv[i + 1])) return false;
+            currentEngine = StepEngine::Margolus;
+            autoSwitchEngine = false;
+            i++;
+        }
+
+        // --wireworld <pattern.rle> runs Wireworld, starting from a pattern
+        else if (SDL_strcmp(argv[i], "--wireworld") == 0 && i + 1 < argc) {
+            wireworldPattern = argv[i + 1];
+            currentEngine = StepEngine::Wireworld;
+            autoSwitchEngine = false;
+            i++;
+        }
+
+        // --lenia <orbium|radius,mu,sigma,dt> runs Lenia, a continuous cellular automaton
+        else if (SDL_strcmp(argv[i], "--lenia") == 0 && i + 1 < argc) {
+            if (!Parse_Lenia_Parameters(argv[i + 1])) return false;
+            currentEngine = StepEngine::Lenia;
+            autoSwitchEngine = false;
+            i++;
+        }
+
+        // --life3d <rule> runs life in 3D with a rule like 4555, on --depth <N> slices
+        else if (SDL_strcmp(argv[i], "--life3d") == 0 && i + 1 < argc) {
+            if (!Parse_Life3D_Rule(argv[i + 1])) return false;
+            currentEngine = StepEngine::Life3D;
+            autoSwitchEngine = false;
+            i++;
+        }
+        else if (SDL_strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            char* end;
+            const long value = SDL_strtol(argv[i + 1], &end, 10);
+            if (end == argv[i + 1] || *end != '\0' || value < 3 || value > MAX_VOLUME_DEPTH) {
+                SDL_Log("Depth should be a number from 3 to %d: %s", MAX_VOLUME_DEPTH, argv[i + 1]);
+                return false;
+            }
+            volumeDepth = (int)value;
+            i++;
+        }
+
+        // --hex <rule> runs life on a hexagonal grid, with a rule like B2/S34
+        else if (SDL_strcmp(argv[i], "--hex") == 0 && i + 1 < argc) {
+            if (!Parse_Hex_Rule(argv[i + 1])) return false;
+            currentEngine = StepEngine::Hex;
+            autoSwitchEngine = false;
+            i++;
+        }
+
+        // --elementary <N> runs the 1D elementary automaton rule N (0 to 255), e.g. 30 or 110
+        else if (SDL_strcmp(argv[i], "--elementary") == 0 && i + 1 < argc) {
+            if (!Parse_Elementary_Rule(argv[i + 1])) return false;
+            currentEngine = StepEngine::Elementary;
+            autoSwitchEngine = false;
+            i++;
+        }
+
+        // --kernel <simple|stream|rowsum|jit> picks the kernel the dense engine uses on the linear layout
+        else if (SDL_strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            if (SDL_strcmp(argv[i + 1], "simple") == 0) denseKernel = DenseKernel::Simple;
+            else if (SDL_strcmp(argv[i + 1], "stream") == 0) denseKernel = DenseKernel::Streaming;
+            else if (SDL_strcmp(argv[i + 1], "rowsum") == 0) denseKernel = DenseKernel::RowSum;
+            else if (SDL_strcmp(argv[i + 1], "jit") == 0) denseKernel = DenseKernel::Compiled;
+            else {
+                SDL_Log("Unknown kernel: %s", argv[i + 1]);
+                return false;
+            }
+            i++;
+        }
+
+        // --prefetch-distance <lines> sets how far ahead the streaming kernel prefetches
+        else if (SDL_strcmp(argv[i], "--prefetch-distance") == 0 && i + 1 < argc) {
+            prefetchDistance = SDL_max(0, SDL_atoi(argv[i + 1]));
+            i++;
+        }
+
+        // --threads <N> steps the board on N threads
+        else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = SDL_max(1, SDL_atoi(argv[i + 1]));
+
+            const int maxThreads = MAX_THREADS_PER_CORE * SDL_max(1, SDL_GetNumLogicalCPUCores());
+            if (threadCount > maxThreads) {
+                SDL_Log("Using %d threads (%d per core) instead of %d", maxThreads, MAX_THREADS_PER_CORE, threadCount);
+                threadCount = maxThreads;
+            }
+            i++;
+        }
+
+        // --generations <N> sets how far headless runs step
+        else if (SDL_strcmp(argv[i], "--generations") == 0 && i + 1 < argc) {
+            generationsToRun = SDL_atoi(argv[i + 1]);
+            i++;
+        }
+
+        // --size <W>x<H> sets the size of the board
+        else if (SDL_strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (SDL_sscanf(argv[i + 1], "%dx%d", &simWidth, &simHeight) != 2 || simWidth < 3 || simHeight < 3) {
+                SDL_Log("Board size should look like 480x270, and be at least 3x3: %s", argv[i + 1]);
+                return false;
+            }
+            i++;
+        }
+
+        // --layout <linear|morton|rows> picks how the grid is arranged in memory
+        else if (SDL_strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            if (SDL_strcmp(argv[i + 1], "linear") == 0) requestedLayout = GridLayout::Linear;
+            else if (SDL_strcmp(argv[i + 1], "morton") == 0) requestedLayout = GridLayout::Morton;
+            else if (SDL_strcmp(argv[i + 1], "rows") == 0) requestedLayout = GridLayout::RowMajor;
+            else {
+                SDL_Log("Unknown layout: %s", argv[i + 1]);
+                return false;
+            }
+            i++;
+        }
+
+        // --stride <cells> sets how far apart the rows of the row-major layout start
+        else if (SDL_strcmp(argv[i], "--stride") == 0 && i + 1 < argc) {
+            requestedStride = SDL_atoi(argv[i + 1]);
+            if (requestedStride <= 0) {
+                SDL_Log("Invalid stride: %s", argv[i + 1]);
+                return false;
+            }
+            i++;
+        }
+
+        // --random <density> starts with a random board, --seed <N> makes it repeatable
+        else if (SDL_strcmp(argv[i], "--random") == 0 && i + 1 < argc) {
+            randomDensity = (float)SDL_atof(argv[i + 1]);
+            i++;
+        }
+        else if (SDL_strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            randomSeed = SDL_strtoull(argv[i + 1], NULL, 10);
+            if (randomSeed == 0) {
+                // SDL_srand(0) seeds from the clock, which is exactly what --seed is meant to avoid
+                SDL_Log("The seed has to be 1 or more");
+                return false;
+            }
+            i++;
+        }
+
+        // --no-huge-pages keeps the big buffers on regular pages, for comparison
+        else if (SDL_strcmp(argv[i], "--no-huge-pages") == 0) {
+            useHugePages = false;
+        }
+
+        // --headless steps --generations generations without a window and reports how long it took
+        else if (SDL_strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        }
+
+        // --render <points|texture> picks how 2D boards get drawn
+        else if (SDL_strcmp(argv[i], "--render") == 0 && i + 1 < argc) {
+            if (SDL_strcmp(argv[i + 1], "points") == 0) renderPath = RenderPath::Points;
+            else if (SDL_strcmp(argv[i + 1], "texture") == 0) renderPath = RenderPath::Texture;
+            else {
+                SDL_Log("Unknown render path: %s", argv[i + 1]);
+                return false;
+            }
+            i++;
+        }
+
+        // --render-bench <frames> times drawing the board offscreen at a range of densities and scales
+        else if (SDL_strcmp(argv[i], "--render-bench") == 0 && i + 1 < argc) {
+            renderBenchFrames = SDL_max(1, SDL_atoi(argv[i + 1]));
+            i++;
+        }
+
+        // --trace <file> records how long each part of every frame takes, as a chrome trace
+        else if (SDL_strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[i + 1];
+            i++;
+        }
+
+        // --metrics <file> writes prometheus metrics to a file every --metrics-interval <seconds> (10 by default)
+        else if (SDL_strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsFile = argv[i + 1];
+            i++;
+        }
+        else if (SDL_strcmp(argv[i], "--metrics-interval") == 0 && i + 1 < argc) {
+            metricsInterval = SDL_max(1, SDL_atoi(argv[i + 1]));
+            i++;
+        }
+
+        // --record <file> writes every input event of the session to a file, --replay <file> plays one back headless
+        else if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFile = argv[i + 1];
+            i++;
+        }
+        else if (SDL_strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = argv[i + 1];
+            i++;
+        }
+
+        // --counters reads the hardware performance counters around every step, and logs them on exit
+        else if (SDL_strcmp(argv[i], "--counters") == 0) {
+            useCounters = true;
+        }
+
+        else {
+            SDL_Log("Unknown or incomplete option: %s", argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
 // runs on an input event
 SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
 {
+    Record_Event(event);
+
     if (event->type == SDL_EVENT_QUIT) {
         return SDL_APP_SUCCESS;
     }
@@ -93,6 +639,21 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
         if (steps_per_second > MAX_STEPS_PER_SECOND) steps_per_second = MAX_STEPS_PER_SECOND;
     }
 
+    // the left arrow key undoes a step of a reversible block rule
+    else if (event->type == SDL_EVENT_KEY_DOWN) {
+        if (event->key.key == SDLK_LEFT) Step_Back();
+
+        // T starts and stops recording a trace (see --trace)
+        else if (event->key.key == SDLK_T) Trace_Toggle();
+
+        // up and down move through the slices of a 3D board, and P shows them all at once
+        else if (currentEngine == StepEngine::Life3D) {
+            if (event->key.key == SDLK_UP) Life3D_Change_Slice(-1);
+            else if (event->key.key == SDLK_DOWN) Life3D_Change_Slice(1);
+            else if (event->key.key == SDLK_P) Life3D_Toggle_Projection();
+        }
+    }
+
     // clicking the left mouse button begins painting
     else if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
         if (event->button.button == 1) {
@@ -123,11 +684,238 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
     return SDL_APP_CONTINUE;
 }
 
+// makes room for the grid and render buffers, now that the board size and layout are known
+bool Allocate_Grid()
+{
+    const size_t cells = Grid_Cell_Count();
+    currentState = (bool*)Allocate_Buffer(cells * sizeof(bool), "grid");
+    nextState = (bool*)Allocate_Buffer(cells * sizeof(bool), "next grid");
+    renderPoints = (SDL_FPoint*)Allocate_Buffer((size_t)simWidth * simHeight * sizeof(SDL_FPoint), "render points");
+    if (currentState == NULL || nextState == NULL || renderPoints == NULL) return false;
+
+    if (currentEngine == StepEngine::TileMemo && !Tile_Memo_Allocate()) return false;
+    if (currentEngine == StepEngine::Wireworld && !Wireworld_Allocate()) return false;
+    return true;
+}
+
+// fills the board with random live cells, each alive with the given probability
+void Randomize_Grid(float density)
+{
+    SDL_srand(randomSeed);
+    for (int x = 0; x < simWidth; x++) {
+        for (int y = 0; y < simHeight; y++) {
+            if (SDL_randf() < density) Try_Paint_Point(x, y);
+        }
+    }
+}
+
+// the number of cells each step updates
+double Cell_Updates_Per_Step()
+{
+    double cellUpdates = (double)simWidth * simHeight;
+    if (currentEngine == StepEngine::Life3D) cellUpdates *= volumeDepth;
+    if (currentEngine == StepEngine::Elementary) cellUpdates /= simHeight; // only the newest row is stepped
+    return cellUpdates;
+}
+
+// steps a headless run by one generation, and reports the timings once it's done
+SDL_AppResult Run_Headless_Step()
+{
+    if (generationsRun >= generationsToRun) {
+        const double seconds = (double)headlessStepTicks / (double)SDL_GetPerformanceFrequency();
+        const double cellUpdates = generationsRun * Cell_Updates_Per_Step();
+
+        SDL_Log("%d generations of %dx%d in %.3f s: %.1f gens/s, %.3f ns per cell, population %d",
+            generationsRun, simWidth, simHeight, seconds, generationsRun / seconds,
+            seconds * 1e9 / cellUpdates, population);
+        return SDL_APP_SUCCESS;
+    }
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    Counters_Begin(0);
+    {
+        TraceSpan span("step");
+        Update_Simulation();
+    }
+    Counters_End(0);
+    const Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    headlessStepTicks += ticks;
+    if (metricsFile != NULL) Metrics_Record_Step(ticks, population);
+
+    generationsRun++;
+    return SDL_APP_CONTINUE;
+}
+
+// plays back a frame of a recording: its events, painting, and a step if the recorded frame stepped.
+// only the steps are timed, and once the recording is over the board is checked against where it ended
+SDL_AppResult Run_Replay_Frame()
+{
+    SDL_Event event;
+    while (Replay_Next_Event(&event)) SDL_AppEvent(NULL, &event);
+
+    PaintCells();
+
+    if (Replay_Step()) {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        Counters_Begin(0);
+        {
+            TraceSpan span("step");
+            Update_Simulation();
+        }
+        Counters_End(0);
+        const Uint64 ticks = SDL_GetPerformanceCounter() - start;
+        headlessStepTicks += ticks;
+        if (metricsFile != NULL) Metrics_Record_Step(ticks, population);
+        replayStepsRun++;
+    }
+
+    if (Replay_End_Frame()) return SDL_APP_CONTINUE;
+
+    const double seconds = (double)headlessStepTicks / (double)SDL_GetPerformanceFrequency();
+    const Uint64 hash = Grid_Hash();
+    SDL_Log("replayed %d steps of %dx%d in %.3f s: %.1f gens/s, population %d, hash %llu",
+        replayStepsRun, simWidth, simHeight, seconds, seconds > 0 ? replayStepsRun / seconds : 0.0, population, (unsigned long long)hash);
+
+    Uint64 expectedHash = 0;
+    int expectedPopulation = 0;
+    if (!Replay_Expected(&expectedHash, &expectedPopulation)) {
+        SDL_Log("the recording doesn't say where the board ended up, so there's nothing to check against");
+        return SDL_APP_SUCCESS;
+    }
+    if (hash != expectedHash || population != expectedPopulation) {
+        SDL_Log("the board doesn't match the recording, which ended with population %d, hash %llu",
+            expectedPopulation, (unsigned long long)expectedHash);
+        if (replayOptionsGiven) SDL_Log("(options given alongside --replay replace the recorded ones, which might be why)");
+        return SDL_APP_FAILURE;
+    }
+    SDL_Log("the board matches the recording");
+    return SDL_APP_SUCCESS;
+}
+
+// an FNV-1a hash of a buffer
+Uint64 Hash_Bytes(const void* data, size_t bytes)
+{
+    const Uint8* byte = (const Uint8*)data;
+    Uint64 hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < bytes; i++) hash = (hash ^ byte[i]) * 1099511628211ULL;
+    return hash;
+}
+
+// a hash of the whole board, to check that two runs ended up in the same place.
+// engines that keep a board of their own hash it themselves
+Uint64 Grid_Hash()
+{
+    switch (currentEngine) {
+    case StepEngine::Wireworld: return Wireworld_Hash();
+    case StepEngine::Lenia: return Lenia_Hash();
+    case StepEngine::Life3D: return Life3D_Hash();
+    case StepEngine::Hex: return Hex_Hash();
+    case StepEngine::Elementary: return Elementary_Hash();
+    default: break;
+    }
+
+    // the dense grid is read cell by cell, so it hashes the same whatever the layout
+    std::vector<Uint8> column(simHeight);
+    Uint64 hash = 0;
+    for (int x = 0; x < simWidth; x++) {
+        for (int y = 0; y < simHeight; y++) column[y] = Get_Cell(x, y) ? 1 : 0;
+        hash = hash * 31 + Hash_Bytes(column.data(), column.size());
+    }
+    return hash;
+}
+
+// empties the board
+void Clear_Grid()
+{
+    SDL_memset(currentState, 0, Grid_Cell_Count() * sizeof(bool));
+    SDL_memset(nextState, 0, Grid_Cell_Count() * sizeof(bool));
+    population = 0;
+    liveBox = staleBox = Empty_Box();
+    Clear_Rendered_Points();
+    if (threadCount > 1) Parallel_Invalidate();
+}
+
+// times drawing the board with the real SDL renderer, on the offscreen video driver and the software
+// renderer so it works without a display, for every density, render scale and render path. the board
+// is stepped between frames (outside the timing), so the texture path has changed tiles to upload
+// like it would in the window. returns false if there's no renderer to time
+bool Run_Render_Bench(int frames)
+{
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen,dummy");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_Log("render bench: %dx%d board, %d frames each, %s video driver, software renderer",
+        simWidth, simHeight, frames, SDL_GetCurrentVideoDriver());
+    SDL_Log("  scale  density  path     frame ms: mean  median     p95");
+
+    std::vector<double> frameTimes(frames);
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+
+    for (const int scale : RENDER_BENCH_SCALES) {
+        renderScale = scale;
+        const int windowWidth = SDL_min(simWidth * scale, MAX_WINDOW_WIDTH);
+        const int windowHeight = SDL_min(simHeight * scale, MAX_WINDOW_HEIGHT);
+
+        if (!SDL_CreateWindowAndRenderer("cells", windowWidth, windowHeight, 0, &window, &renderer)) {
+            SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
+            return false;
+        }
+        SDL_SetRenderScale(renderer, (float)scale, (float)scale);
+
+        for (const float density : RENDER_BENCH_DENSITIES) {
+            for (const RenderPath path : { RenderPath::Points, RenderPath::Texture }) {
+                renderPath = path;
+                Clear_Grid();
+                Randomize_Grid(density);
+
+                double livePoints = 0;
+                for (int frame = 0; frame < frames; frame++) {
+                    Update_Simulation();
+                    livePoints += renderPointCount;
+
+                    const Uint64 start = SDL_GetPerformanceCounter();
+                    Render_Frame();
+                    frameTimes[frame] = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+                }
+
+                double total = 0;
+                for (const double time : frameTimes) total += time;
+                std::sort(frameTimes.begin(), frameTimes.end());
+
+                SDL_Log("  %5d  %7.2f  %-7s  %14.3f  %6.3f  %6.3f   (%.0f live cells)", scale, density,
+                    path == RenderPath::Points ? "points" : "texture", total / frames, frameTimes[frames / 2],
+                    frameTimes[SDL_min(frames - 1, frames * 95 / 100)], livePoints / frames);
+            }
+        }
+
+        // the texture belongs to the renderer, so it has to go first
+        Board_Texture_Release();
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        renderer = NULL;
+        window = NULL;
+    }
+
+    return true;
+}
+
 // runs every frame
 SDL_AppResult SDL_AppIterate(void* appstate)
 {
+    if (replayFile != NULL) return Run_Replay_Frame();
+    if (headless) return Run_Headless_Step();
+
+    TraceSpan frameSpan("frame");
+
     // handles mouse cell painting
-    PaintCells();
+    {
+        TraceSpan span("paint");
+        PaintCells();
+    }
 
     // if the simulation isn't paused
     if (steps_per_second > 0) {
@@ -140,29 +928,63 @@ SDL_AppResult SDL_AppIterate(void* appstate)
         // if the elapsed time is greater than the seconds per step, update the simulation
         if (elapsed >= seconds_per_step) {
 
+            TraceSpan span("step");
+            const Uint64 start = SDL_GetPerformanceCounter();
+            Counters_Begin(0);
             Update_Simulation();
+            Counters_End(0);
+            if (metricsFile != NULL) Metrics_Record_Step(SDL_GetPerformanceCounter() - start, population);
             last_step_time = now;
+            Record_Step();
         }
     }
 
     // if any points were drawn, rerender the screen
-    if (needs_new_render) {
+    if (needs_new_render) Render_Frame();
 
-        // first make everything black
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-        SDL_RenderClear(renderer);
+    Record_End_Frame();
+    return SDL_APP_CONTINUE;
+}
 
-        // then render all the points white
+// draws the board and puts it on the screen
+void Render_Frame()
+{
+    TraceSpan renderSpan("render");
+
+    // first make everything black
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(renderer);
+
+    // then render all the points white (Wireworld, Lenia, hex and 1D boards draw themselves).
+    // 2D boards go through a texture that only has the tiles that changed uploaded to it, unless
+    // --render points says otherwise, and 3D views (and boards too big for a texture) are drawn as points
+    if (currentEngine == StepEngine::Wireworld) Wireworld_Render(renderer);
+    else if (currentEngine == StepEngine::Lenia) Lenia_Render(renderer);
+    else if (currentEngine == StepEngine::Hex) Hex_Render(renderer);
+    else if (currentEngine == StepEngine::Elementary) Elementary_Render(renderer);
+    else if (currentEngine == StepEngine::Life3D || renderPath == RenderPath::Points
+        || !Board_Texture_Render(renderer, renderPoints, renderPointCount)) {
         SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
         SDL_RenderPoints(renderer, renderPoints, renderPointCount);
+    }
 
-        // update the screen
+    // update the screen
+    {
+        TraceSpan span("present");
         SDL_RenderPresent(renderer);
-
-        needs_new_render = false;
     }
 
-    return SDL_APP_CONTINUE;
+    needs_new_render = false;
+}
+
+// the modifier keys held right now, or while this frame was recorded when replaying
+static SDL_Keymod Current_Mod_State()
+{
+    if (replayFile != NULL) return Replay_Mod_State();
+
+    const SDL_Keymod mod = SDL_GetModState();
+    Record_Mod_State(mod);
+    return mod;
 }
 
 // handles painting for a frame
@@ -171,8 +993,10 @@ void PaintCells()
     // if the mouse is down and on the screen, paint live pixels
     if (mouseDown) {
 
-        int mouseCellX = (int)(mouseX / RENDER_SCALE);
-        int mouseCellY = (int)(mouseY / RENDER_SCALE);
+        paintingElectrons = (Current_Mod_State() & SDL_KMOD_SHIFT) != 0;
+
+        int mouseCellX = (int)(mouseX / renderScale);
+        int mouseCellY = (int)(mouseY / renderScale);
 
         // interpolates between previous and current mouse position using Bresenham's algorithm
         if (mouseWasDown) {
@@ -249,9 +1073,35 @@ void Paint_Line_Steep(int x0, int y0, int x1, int y1, int dx, int dy) {
 // tries to paint a single live cell at the given x,y position
 // returns true if the point was inside the window, false otherwise
 bool Try_Paint_Point(int x, int y) {
-    if (x >= 0 && y >= 0 && x < SIM_WIDTH && y < SIM_HEIGHT) {
-        if (currentState[x][y] == false) {
-            currentState[x][y] = true;
+    if (x >= 0 && y >= 0 && x < simWidth && y < simHeight) {
+        if (currentEngine == StepEngine::Wireworld) {
+            Wireworld_Paint(x, y, paintingElectrons);
+            return true;
+        }
+        if (currentEngine == StepEngine::Lenia) {
+            Lenia_Paint(x, y);
+            return true;
+        }
+        if (currentEngine == StepEngine::Life3D) {
+            Life3D_Paint(x, y);
+            return true;
+        }
+        if (currentEngine == StepEngine::Hex) {
+            Hex_Paint(x, y);
+            return true;
+        }
+        if (currentEngine == StepEngine::Elementary) {
+            Elementary_Paint(x, y);
+            return true;
+        }
+
+        const size_t index = Cell_Index(x, y);
+        if (currentState[index] == false) {
+            currentState[index] = true;
+            liveBox = Box_Add_Point(liveBox, x, y);
+            population++;
+            if (currentEngine == StepEngine::Sparse) Sparse_Add_Cell(x, y);
+            if (threadCount > 1) Parallel_Mark_Changed(x, y);
             Add_Rendered_Point(x, y);
         }
         return true;
@@ -259,31 +1109,165 @@ bool Try_Paint_Point(int x, int y) {
     else return false;
 }
 
-// updates the game of life simulation according to the standard rules
+// steps the simulation with the current engine
 void Update_Simulation()
+{
+    // only Update_Simulation_Dense keeps the live boxes up to date
+    bool boxesKept = false;
+
+    switch (currentEngine) {
+    case StepEngine::Dense:
+        if (gridLayout == GridLayout::Morton) Update_Simulation_Dense_Morton();
+        else if (gridLayout == GridLayout::RowMajor && denseKernel == DenseKernel::RowSum) {
+            population = Update_Simulation_Row_Sum(currentState, nextState);
+            std::swap(currentState, nextState);
+        }
+        else if (gridLayout == GridLayout::RowMajor) {
+            Update_Simulation_Dense();
+            boxesKept = true;
+        }
+        else if (!Rule_Is_Life() || denseKernel == DenseKernel::Compiled) {
+            population = Update_Simulation_Rule(currentState, nextState, renderPoints);
+            renderPointCount = population;
+            needs_new_render = true;
+            std::swap(currentState, nextState);
+        }
+        else if (threadCount > 1) {
+            population = Parallel_Update_Simulation(currentState, nextState, renderPoints);
+            renderPointCount = population;
+            needs_new_render = true;
+            std::swap(currentState, nextState);
+        }
+        else if (denseKernel == DenseKernel::Streaming) {
+            population = Update_Simulation_Streaming(currentState, nextState, prefetchDistance);
+            std::swap(currentState, nextState);
+        }
+        else if (denseKernel == DenseKernel::RowSum) {
+            population = Update_Simulation_Row_Sum(currentState, nextState);
+            std::swap(currentState, nextState);
+        }
+        else {
+            Update_Simulation_Dense();
+            boxesKept = true;
+        }
+        break;
+    case StepEngine::Sparse:
+        Sparse_Update_Simulation();
+        population = Sparse_Population();
+        break;
+    case StepEngine::TileMemo:
+        Tile_Memo_Update_Simulation();
+        population = Tile_Memo_Population();
+        break;
+    case StepEngine::Margolus:
+        population = Margolus_Update_Simulation(currentState);
+        break;
+    case StepEngine::Wireworld:
+        Wireworld_Update_Simulation();
+        population = Wireworld_Population();
+        break;
+    case StepEngine::Lenia:
+        Lenia_Update_Simulation();
+        population = Lenia_Population();
+        break;
+    case StepEngine::Life3D:
+        Life3D_Update_Simulation();
+        population = Life3D_Population();
+        break;
+    case StepEngine::Hex:
+        Hex_Update_Simulation();
+        population = Hex_Population();
+        break;
+    case StepEngine::Elementary:
+        Elementary_Update_Simulation();
+        population = Elementary_Population();
+        break;
+    }
+
+    if (!boxesKept) liveBox = staleBox = Whole_Board();
+
+    if (autoSwitchEngine) Choose_Engine();
+}
+
+// steps the simulation back a generation, if the rule is reversible
+void Step_Back()
+{
+    if (currentEngine == StepEngine::Margolus && Margolus_Is_Reversible()) {
+        population = Margolus_Step_Back(currentState);
+    }
+}
+
+// switches between the dense and sparse engines based on the measured live cell density
+void Choose_Engine()
+{
+    const double density = (double)population / ((double)simWidth * simHeight);
+
+    if (currentEngine == StepEngine::Dense && density < SPARSE_ENTER_DENSITY) {
+        Sparse_Load_From_Grid();
+        currentEngine = StepEngine::Sparse;
+        SDL_Log("switched to the sparse engine (density %.4f)", density);
+    }
+    else if (currentEngine == StepEngine::Sparse && density > SPARSE_EXIT_DENSITY) {
+        // the sparse engine keeps the dense grid up to date, so nothing needs converting
+        // (but the parallel engine has to look at every tile again)
+        currentEngine = StepEngine::Dense;
+        if (threadCount > 1) Parallel_Invalidate();
+        SDL_Log("switched to the dense engine (density %.4f)", density);
+    }
+}
+
+// updates the game of life simulation according to the standard rules, checking every cell
+// this is the kernel for the linear and row-major layouts
+void Update_Simulation_Dense()
 {
     int x, y; // current xy position
+    int i, j; // position within the region being stepped
 
     // current and absolute position being checked for a neighbor, relative to x and y above
     // these are seperate variables because the simulation wraps around on both axes
-	// e.g. -1 <= dx <= 1 always, but nx might wrap around to 0 if x = SIM_WIDTH - 1
+	// e.g. -1 <= dx <= 1 always, but nx might wrap around to 0 if x = simWidth - 1
     int dx, dy;
     int nx, ny;
 
     int neighbors; // neighbor count for the current cell
 
     Clear_Rendered_Points(); // clear all points from being rendered
-
-    for (x = 0; x < SIM_WIDTH; x++) {
-        for (y = 0; y < SIM_HEIGHT; y++) {
+    population = 0;
+
+    // only cells next to a live one can come alive, so everything more than a cell away from the
+    // live box stays dead. the cells that were alive in nextState get stepped too, so they're
+    // overwritten rather than left there
+    const Box region = Box_Union(Box_Grow(liveBox, 1), staleBox);
+
+    // cell (x, y) is at x * xStride + y * yStride, and the inner loop runs along whichever
+    // direction is next to each other in memory
+    const bool rowMajor = gridLayout == GridLayout::RowMajor;
+    const size_t xStride = rowMajor ? 1 : (size_t)simHeight;
+    const size_t yStride = rowMajor ? (size_t)gridStride : 1;
+    const int outerLength = rowMajor ? region.y.length : region.x.length;
+    const int innerLength = rowMajor ? region.x.length : region.y.length;
+
+    // where the live cells of the next generation are within the region
+    int firstLiveI = region.x.length, lastLiveI = -1;
+    int firstLiveJ = region.y.length, lastLiveJ = -1;
+
+    for (int outer = 0; outer < outerLength; outer++) {
+        for (int inner = 0; inner < innerLength; inner++) {
+            i = rowMajor ? inner : outer;
+            j = rowMajor ? outer : inner;
+
+            x = region.x.start + i;
+            if (x >= simWidth) x -= simWidth;
+            y = region.y.start + j;
+            if (y >= simHeight) y -= simHeight;
 
             neighbors = 0;
             for (dx = -1; dx <= 1; dx++) {
 
                 // find the x coordinate of the adjacent cell
                 nx = x + dx;
-                if (nx < 0) nx = SIM_WIDTH - 1;
-                if (nx == SIM_WIDTH) nx = 0;
+                if (nx < 0) nx = simWidth - 1;
+                if (nx == simWidth) nx = 0;
 
                 for (dy = -1; dy <= 1; dy++) {
 
@@ -292,11 +1276,11 @@ void Update_Simulation()
 
 					// find the y coordinate of the adjacent cell
                     ny = y + dy;
-                    if (ny < 0) ny = SIM_HEIGHT - 1;
-                    if (ny == SIM_HEIGHT) ny = 0;
+                    if (ny < 0) ny = simHeight - 1;
+                    if (ny == simHeight) ny = 0;
 
 					// if the adjacent cell is alive, increment the neighbor count
-                    if (currentState[nx][ny]) neighbors++;
+                    if (currentState[nx * xStride + ny * yStride]) neighbors++;
 
 					// no need to check for more neighbors if we already have 4
                     if (neighbors > 3) break;
@@ -317,32 +1301,128 @@ void Update_Simulation()
             should be explicitly set each simulation step, even if it isnt changing.
             */
             
-            if (currentState[x][y]) {
+            const size_t index = x * xStride + y * yStride;
+            if (currentState[index]) {
                 if (neighbors < 2 || neighbors > 3) {
-                    nextState[x][y] = false;
+                    nextState[index] = false;
                 }
                 else {
-                    nextState[x][y] = true;
+                    nextState[index] = true;
+                    population++;
                     Add_Rendered_Point(x, y);
                 }
             }
             else {
                 if (neighbors == 3) {
-                    nextState[x][y] = true;
+                    nextState[index] = true;
+                    population++;
                     Add_Rendered_Point(x, y);
                 }
-                else nextState[x][y] = false;
+                else nextState[index] = false;
+            }
+
+            if (nextState[index]) {
+                firstLiveI = SDL_min(firstLiveI, i);
+                lastLiveI = SDL_max(lastLiveI, i);
+                firstLiveJ = SDL_min(firstLiveJ, j);
+                lastLiveJ = SDL_max(lastLiveJ, j);
             }
         }
     }
+
+    // the old live cells are in what's about to become nextState
+    staleBox = liveBox;
+    if (lastLiveI < 0) liveBox = Empty_Box();
+    else {
+        liveBox.x = { (region.x.start + firstLiveI) % simWidth, lastLiveI - firstLiveI + 1 };
+        liveBox.y = { (region.y.start + firstLiveJ) % simHeight, lastLiveJ - firstLiveJ + 1 };
+    }
+
     // swaps the two arrays, so currentState will point to this step's output
     // and nextState will point to the old state (and should be totally overwritten next sim step)
     std::swap(currentState, nextState);
 }
 
+// the same rules as Update_Simulation_Dense, for the morton layout.
+// the board is stepped a tile at a time in Z-order: each 8x8 tile is copied into a 10x10
+// scratch buffer along with its border, so the neighbors of every cell are at fixed offsets
+// and the 9 tiles being read were all touched recently, which keeps them in cache
+void Update_Simulation_Dense_Morton()
+{
+    constexpr int BORDERED = MORTON_TILE_SIZE + 2;
+    bool tile[BORDERED][BORDERED];
+
+    Clear_Rendered_Points();
+    population = 0;
+
+    const size_t tileCount = Morton_Tile_Count();
+    for (size_t t = 0; t < tileCount; t++) {
+
+        int tx, ty;
+        if (!Morton_Tile_Position(t, &tx, &ty)) continue; // padding past the edge of the board
+
+        const int x0 = tx * MORTON_TILE_SIZE;
+        const int y0 = ty * MORTON_TILE_SIZE;
+        const bool* cells = &currentState[t * MORTON_TILE_CELLS];
+
+        // tiles on the right and bottom edges can be cut short by the edge of the board
+        const bool fullTile = x0 + MORTON_TILE_SIZE <= simWidth && y0 + MORTON_TILE_SIZE <= simHeight;
+        const int width = SDL_min(MORTON_TILE_SIZE, simWidth - x0);
+        const int height = SDL_min(MORTON_TILE_SIZE, simHeight - y0);
+
+        // fill in the scratch tile, wrapping around the edges of the board for the border
+        for (int i = 0; i < BORDERED; i++) {
+            int x = x0 + i - 1;
+            if (x < 0) x += simWidth;
+            if (x >= simWidth) x -= simWidth;
+
+            for (int j = 0; j < BORDERED; j++) {
+                // the inside of a full tile is copied straight out of its cache line below
+                if (fullTile && i > 0 && i <= MORTON_TILE_SIZE && j > 0 && j <= MORTON_TILE_SIZE) continue;
+
+                int y = y0 + j - 1;
+                if (y < 0) y += simHeight;
+                if (y >= simHeight) y -= simHeight;
+
+                tile[i][j] = currentState[Morton_Index(x, y)];
+            }
+            if (fullTile && i > 0 && i <= MORTON_TILE_SIZE) {
+                std::copy(cells + (i - 1) * MORTON_TILE_SIZE, cells + i * MORTON_TILE_SIZE, &tile[i][1]);
+            }
+        }
+
+        bool* next = &nextState[t * MORTON_TILE_CELLS];
+        for (int i = 1; i <= width; i++) {
+            for (int j = 1; j <= height; j++) {
+                const int neighbors = tile[i - 1][j - 1] + tile[i - 1][j] + tile[i - 1][j + 1]
+                    + tile[i][j - 1] + tile[i][j + 1]
+                    + tile[i + 1][j - 1] + tile[i + 1][j] + tile[i + 1][j + 1];
+
+                const bool alive = neighbors == 3 || (neighbors == 2 && tile[i][j]);
+                next[(i - 1) * MORTON_TILE_SIZE + (j - 1)] = alive;
+
+                if (alive) {
+                    population++;
+                    Add_Rendered_Point(x0 + i - 1, y0 + j - 1);
+                }
+            }
+        }
+    }
+
+    std::swap(currentState, nextState);
+}
+
 // sets the number of points that will be passed to the renderer to 0
+// the screen still needs redrawing even if no points get added back (e.g. everything died)
 void Clear_Rendered_Points() {
     renderPointCount = 0;
+    needs_new_render = true;
+}
+
+// redraws the screen on the next frame, for engines that draw themselves instead of through
+// the render points
+void Request_Redraw() {
+    needs_new_render = true;
 }
 
 //sets the next point in the render buffer to the given xy value 
@@ -355,8 +1435,43 @@ void Add_Rendered_Point(int x, int y) {
     needs_new_render = true;
 }
 
+// the cells of the current generation, in the order Cell_Index says
+const bool* Grid_Cells() {
+    return currentState;
+}
+
+// returns whether the cell at the given x,y position is alive
+bool Get_Cell(int x, int y) {
+    return currentState[Cell_Index(x, y)];
+}
+
+// sets the cell at the given x,y position without touching the render buffer or population
+void Set_Cell(int x, int y, bool alive) {
+    currentState[Cell_Index(x, y)] = alive;
+    if (alive) liveBox = Box_Add_Point(liveBox, x, y);
+}
+
+// sets the cell at the given x,y position in the next generation
+// engines that build the next generation a piece at a time write through this, then call Swap_States
+void Set_Next_Cell(int x, int y, bool alive) {
+    nextState[Cell_Index(x, y)] = alive;
+}
+
+// makes the next generation the current one
+void Swap_States() {
+    std::swap(currentState, nextState);
+}
+
 // i think this is necessary to leave here?
 void SDL_AppQuit(void* appstate, SDL_AppResult result)
 {
-
+    Tile_Memo_Log_Stats();
+    Scheduler_Log_Stats();
+    Board_Texture_Log_Stats();
+    Counters_Log_Stats(Cell_Updates_Per_Step());
+    Trace_Write();
+    if (recordFile != NULL) Record_Stop(Grid_Hash(), population);
+    Metrics_Stop();
+    Scheduler_Stop();
+    Jit_Release();
 }
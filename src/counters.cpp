@@ -0,0 +1,208 @@
+// hardware performance counters (cycles, instructions, last level cache misses and branch misses)
+// around each step, for working out why a kernel is slow on a particular machine
+//
+// every worker thread gets its own group of counters through perf_event_open, opened the first time
+// the thread starts counting. worker 0 (the main thread) counts from the start to the end of each
+// Update_Simulation, and the other workers count while they're in a pass, so time spent parked
+// between passes isn't included. the groups are read once, on exit.
+//
+// counters can be missing for lots of reasons (not linux, a virtual machine without a PMU,
+// perf_event_paranoid set too high), so anything that can't be opened is logged once and left out,
+// and the step runs the same either way.
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include "counters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum Counter {
+    CYCLES,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    COUNTER_COUNT
+};
+
+static const char* counterNames[COUNTER_COUNT] = { "cycles", "instructions", "LLC misses", "branch misses" };
+
+// one worker's counters. the first one that opened leads the group, and turns them all on and off
+struct CounterGroup {
+    bool opened = false;
+    int leader = -1;
+    int files[COUNTER_COUNT] = { -1, -1, -1, -1 };
+    uint64_t values[COUNTER_COUNT] = {};
+    bool valid[COUNTER_COUNT] = {};
+};
+
+static bool enabled = false;
+static std::vector<CounterGroup> groups;
+static uint64_t steps = 0;
+
+#ifdef __linux__
+
+static int Open_Counter(uint64_t config, int leader)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = leader < 0 ? 1 : 0;
+    attr.exclude_kernel = 1; // so it works with the default perf_event_paranoid of 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // this thread, on whichever cpu it runs on
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+static void Open_Group(CounterGroup& group)
+{
+    static const uint64_t configs[COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    static bool warned = false;
+
+    group.opened = true;
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        group.files[c] = Open_Counter(configs[c], group.leader);
+        if (group.files[c] < 0) {
+            if (!warned) SDL_Log("Couldn't open the %s counter, leaving it out: %s", counterNames[c], std::strerror(errno));
+            warned = true;
+        }
+        else if (group.leader < 0) group.leader = group.files[c];
+    }
+}
+
+static void Enable_Group(const CounterGroup& group, bool on)
+{
+    if (group.leader >= 0) ioctl(group.leader, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+// reads a group's counts, scaled up if the kernel had to share the hardware with something else
+// and only counted part of the time
+static void Read_Group(CounterGroup& group)
+{
+    if (group.leader < 0) return;
+
+    uint64_t buffer[3 + COUNTER_COUNT] = {};
+    if (read(group.leader, buffer, sizeof(buffer)) <= 0) return;
+
+    const uint64_t enabledTime = buffer[1];
+    const uint64_t runningTime = buffer[2];
+    const double scale = (runningTime > 0 && runningTime < enabledTime) ? (double)enabledTime / (double)runningTime : 1.0;
+
+    // the values come in the order the counters were opened
+    uint64_t next = 0;
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        if (group.files[c] < 0 || next >= buffer[0]) continue;
+        group.values[c] = (uint64_t)((double)buffer[3 + next++] * scale);
+        group.valid[c] = true;
+    }
+
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        if (group.files[c] >= 0) close(group.files[c]);
+        group.files[c] = -1;
+    }
+    group.leader = -1;
+}
+
+#else
+
+static void Open_Group(CounterGroup& group)
+{
+    group.opened = true;
+}
+
+static void Enable_Group(const CounterGroup&, bool) {}
+static void Read_Group(CounterGroup&) {}
+
+#endif
+
+// turns counting on for the given number of workers
+// returns false (after saying why) if there are no counters on this system
+bool Counters_Setup(int workerCount)
+{
+#ifdef __linux__
+    groups.assign(workerCount, CounterGroup());
+
+    // try the main thread's group now, so a system without counters is found out straight away
+    Open_Group(groups[0]);
+    if (groups[0].leader < 0) {
+        SDL_Log("Hardware counters aren't available, running without them");
+        return false;
+    }
+
+    enabled = true;
+    return true;
+#else
+    SDL_Log("Hardware counters need linux's perf_event, running without them");
+    return false;
+#endif
+}
+
+// starts counting on the calling thread, which is the given worker
+void Counters_Begin(int worker)
+{
+    if (!enabled) return;
+
+    CounterGroup& group = groups[worker];
+    if (!group.opened) Open_Group(group);
+    Enable_Group(group, true);
+}
+
+// stops counting on the calling thread
+void Counters_End(int worker)
+{
+    if (!enabled) return;
+
+    Enable_Group(groups[worker], false);
+    if (worker == 0) steps++;
+}
+
+// logs the counts of every worker, and per cell update across all of them
+void Counters_Log_Stats(double cellUpdatesPerStep)
+{
+    if (!enabled || steps == 0) return;
+
+    uint64_t totals[COUNTER_COUNT] = {};
+    bool valid[COUNTER_COUNT] = {};
+
+    for (CounterGroup& group : groups) {
+        Read_Group(group);
+        for (int c = 0; c < COUNTER_COUNT; c++) {
+            totals[c] += group.values[c];
+            valid[c] = valid[c] || group.valid[c];
+        }
+    }
+
+    const double cellUpdates = cellUpdatesPerStep * (double)steps;
+    if (valid[CYCLES] && valid[INSTRUCTIONS] && totals[CYCLES] > 0) {
+        SDL_Log("counters: %llu steps, %.2f IPC, %.2f cycles per cell update",
+            (unsigned long long)steps, (double)totals[INSTRUCTIONS] / (double)totals[CYCLES], (double)totals[CYCLES] / cellUpdates);
+    }
+    else SDL_Log("counters: %llu steps", (unsigned long long)steps);
+
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        if (valid[c]) SDL_Log("  %-14s %16llu  %.4f per cell update", counterNames[c], (unsigned long long)totals[c], (double)totals[c] / cellUpdates);
+    }
+
+    if (groups.size() > 1) {
+        for (size_t w = 0; w < groups.size(); w++) {
+            const CounterGroup& group = groups[w];
+            const double ipc = group.values[CYCLES] ? (double)group.values[INSTRUCTIONS] / (double)group.values[CYCLES] : 0.0;
+            SDL_Log("  worker %d: %llu cycles, %.2f IPC, %llu LLC misses, %llu branch misses", (int)w,
+                (unsigned long long)group.values[CYCLES], ipc,
+                (unsigned long long)group.values[CACHE_MISSES], (unsigned long long)group.values[BRANCH_MISSES]);
+        }
+    }
+}
@@ -0,0 +1,255 @@
+// one-dimensional elementary cellular automata, like rule 30 and rule 110. each cell looks at
+// itself and its two neighbors, and bit n of the rule number is its next state when the three
+// of them read n as a binary number (left cell on top)
+//
+// the row is packed into 64-bit words with bit b of word w holding cell 64w + b, so a whole word
+// of cells steps at once: its left and right neighbors are the word shifted by one bit, and the
+// rule is a boolean formula of the three words. every rule gets its own compiled copy of the
+// kernel, so the formula is folded down to a few instructions (rule 30 is left ^ (center | right)).
+//
+// the board is the space-time diagram: each generation is a row, and the last simHeight of them
+// are kept in a ring. the texture they're drawn through is a ring too, so each frame only uploads
+// the rows stepped since the last one, and scrolls by drawing the texture in two pieces.
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "cells.h"
+#include "alloc.h"
+#include "bits.h"
+#include "scheduler.h"
+#include "elementary.h"
+
+// words stepped by each task. rows are usually short, so most of them are a single task
+constexpr int WORDS_PER_TASK = 1024;
+
+// steps words first to last - 1 of a row
+typedef void (*RowKernel)(const uint64_t* row, uint64_t* output, int first, int last);
+
+static int rule = 110;
+static RowKernel kernel = NULL;
+
+static int wordsPerRow = 0;
+
+// the bits of the last word that are on the board
+static uint64_t lastWordMask = 0;
+
+// the last simHeight generations, with the generation g at row g % simHeight
+static uint64_t* history = NULL;
+static long long generation = 0;
+
+// how many cells each task had alive after the last step
+static std::vector<int> taskPopulations;
+
+// the texture the history is drawn through, and the newest generation uploaded to it
+static SDL_Texture* texture = NULL;
+static long long uploadedGeneration = -1;
+static std::vector<Uint32> pixels;
+
+// sets the rule from its number
+// returns false (after logging why) if it can't be read
+bool Parse_Elementary_Rule(const char* text)
+{
+    char* end = NULL;
+    const long number = SDL_strtol(text, &end, 10);
+
+    if (end == text || *end != '\0' || number < 0 || number > 255) {
+        SDL_Log("Couldn't read the elementary rule %s (it should be a number from 0 to 255)", text);
+        return false;
+    }
+
+    rule = (int)number;
+    return true;
+}
+
+// the row generation g is kept in
+static inline uint64_t* History_Row(long long g)
+{
+    return history + (size_t)(g % simHeight) * wordsPerRow;
+}
+
+// the cell to the left (x - 1) of each cell in word w, wrapping around from the first cell to the last
+static inline uint64_t West(const uint64_t* row, int w)
+{
+    const uint64_t carry = (w == 0)
+        ? row[wordsPerRow - 1] >> ((simWidth - 1) % 64)
+        : row[w - 1] >> 63;
+    return (row[w] << 1) | (carry & 1);
+}
+
+// the cell to the right (x + 1) of each cell in word w, wrapping around from the last cell to the first
+static inline uint64_t East(const uint64_t* row, int w)
+{
+    if (w == wordsPerRow - 1) {
+        return ((row[w] & lastWordMask) >> 1) | ((row[0] & 1) << ((simWidth - 1) % 64));
+    }
+    return (row[w] >> 1) | (row[w + 1] << 63);
+}
+
+// one of the four functions of a single word: nothing, its complement, itself or everything.
+// bit 0 of the pattern is the result for a 0 bit, bit 1 for a 1 bit
+template <int PATTERN>
+static inline uint64_t Of(uint64_t word)
+{
+    return (PATTERN == 0) ? 0 : (PATTERN == 1) ? ~word : (PATTERN == 2) ? word : ~0ull;
+}
+
+// picks a where select is set and b where it isn't
+static inline uint64_t Select(uint64_t select, uint64_t a, uint64_t b)
+{
+    return (select & a) | (~select & b);
+}
+
+// the rule as a formula of the three neighborhood words: each combination of the left and
+// center cells leaves one of the four functions of the right cell
+template <int RULE>
+static inline uint64_t Apply_Rule(uint64_t left, uint64_t center, uint64_t right)
+{
+    const uint64_t deadLeft = Select(center, Of<(RULE >> 2) & 3>(right), Of<RULE & 3>(right));
+    const uint64_t liveLeft = Select(center, Of<(RULE >> 6) & 3>(right), Of<(RULE >> 4) & 3>(right));
+    return Select(left, liveLeft, deadLeft);
+}
+
+template <int RULE>
+static void Step_Words(const uint64_t* row, uint64_t* output, int first, int last)
+{
+    for (int w = first; w < last; w++) {
+        output[w] = Apply_Rule<RULE>(West(row, w), row[w], East(row, w));
+    }
+}
+
+// the kernel for every rule, compiled separately
+template <size_t... RULES>
+static RowKernel Pick_Kernel(int number, std::index_sequence<RULES...>)
+{
+    static const RowKernel kernels[] = { Step_Words<(int)RULES>... };
+    return kernels[number];
+}
+
+// makes room for the history, now that the board size is known
+// returns false (after logging why) if it can't be used
+bool Elementary_Setup()
+{
+    wordsPerRow = (simWidth + 63) / 64;
+    lastWordMask = (simWidth % 64 == 0) ? ~0ull : (1ull << (simWidth % 64)) - 1;
+
+    const size_t bytes = (size_t)wordsPerRow * simHeight * sizeof(uint64_t);
+    history = (uint64_t*)Allocate_Buffer(bytes, "elementary history");
+    if (history == NULL) return false;
+    SDL_memset(history, 0, bytes);
+
+    kernel = Pick_Kernel(rule, std::make_index_sequence<256>());
+    taskPopulations.assign((wordsPerRow + WORDS_PER_TASK - 1) / WORDS_PER_TASK, 0);
+    return true;
+}
+
+// fills the first generation with random live cells from the given seed, each alive with the given probability
+void Elementary_Randomize(float density, Uint64 seed)
+{
+    SDL_srand(seed);
+    uint64_t* row = History_Row(generation);
+    for (int x = 0; x < simWidth; x++) {
+        if (SDL_randf() < density) row[x / 64] |= 1ull << (x % 64);
+    }
+    uploadedGeneration = SDL_min(uploadedGeneration, generation - 1);
+    Request_Redraw();
+}
+
+// paints a live cell into the newest generation, whichever row was clicked
+void Elementary_Paint(int x, int y)
+{
+    History_Row(generation)[x / 64] |= 1ull << (x % 64);
+    uploadedGeneration = SDL_min(uploadedGeneration, generation - 1);
+    Request_Redraw();
+    (void)y;
+}
+
+// steps words task * WORDS_PER_TASK onwards of the newest generation
+static void Step_Task(int task, int worker, void* context)
+{
+    const uint64_t* row = History_Row(generation);
+    uint64_t* output = History_Row(generation + 1);
+
+    const int first = task * WORDS_PER_TASK;
+    const int last = SDL_min(first + WORDS_PER_TASK, wordsPerRow);
+    kernel(row, output, first, last);
+
+    // the bits past the end of the board would otherwise fill up with junk
+    if (last == wordsPerRow) output[last - 1] &= lastWordMask;
+
+    int live = 0;
+    for (int w = first; w < last; w++) live += Count_Bits(output[w]);
+    taskPopulations[task] = live;
+
+    (void)worker;
+    (void)context;
+}
+
+// steps the row a generation, writing over the oldest one in the history
+void Elementary_Update_Simulation()
+{
+    Scheduler_Run((int)taskPopulations.size(), Step_Task, NULL);
+    generation++;
+    Request_Redraw();
+}
+
+// the number of live cells in the newest generation
+int Elementary_Population()
+{
+    int population = 0;
+    for (int live : taskPopulations) population += live;
+    return population;
+}
+
+// a hash of the history, and of where the newest generation is in it
+Uint64 Elementary_Hash()
+{
+    return Hash_Bytes(history, (size_t)wordsPerRow * simHeight * sizeof(uint64_t)) + (Uint64)generation;
+}
+
+// draws the history, oldest generation at the top
+void Elementary_Render(SDL_Renderer* renderer)
+{
+    if (texture == NULL) {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, simWidth, simHeight);
+        if (texture == NULL) return;
+        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+        pixels.resize(simWidth);
+    }
+
+    // only the generations stepped since the last frame need uploading (at most a whole ring of them)
+    const long long firstNew = SDL_max(uploadedGeneration + 1, generation - simHeight + 1);
+    for (long long g = firstNew; g <= generation; g++) {
+        const uint64_t* row = History_Row(g);
+        for (int x = 0; x < simWidth; x++) {
+            pixels[x] = ((row[x / 64] >> (x % 64)) & 1) ? 0xffffffff : 0xff000000;
+        }
+
+        const SDL_Rect line = { 0, (int)(g % simHeight), simWidth, 1 };
+        SDL_UpdateTexture(texture, &line, pixels.data(), simWidth * (int)sizeof(Uint32));
+    }
+    uploadedGeneration = generation;
+
+    // until the ring fills up, the rows are in order from the top
+    if (generation < simHeight) {
+        const SDL_FRect destination = { 0, 0, (float)simWidth, (float)simHeight };
+        SDL_RenderTexture(renderer, texture, NULL, &destination);
+        return;
+    }
+
+    // after that the oldest row is the one after the newest, so the texture is drawn from there
+    // down, then from the top of the texture to the newest row
+    const int oldest = (int)((generation + 1) % simHeight);
+    const float below = (float)(simHeight - oldest);
+
+    const SDL_FRect topSource = { 0, (float)oldest, (float)simWidth, below };
+    const SDL_FRect topDestination = { 0, 0, (float)simWidth, below };
+    SDL_RenderTexture(renderer, texture, &topSource, &topDestination);
+
+    if (oldest > 0) {
+        const SDL_FRect bottomSource = { 0, 0, (float)simWidth, (float)oldest };
+        const SDL_FRect bottomDestination = { 0, below, (float)simWidth, (float)oldest };
+        SDL_RenderTexture(renderer, texture, &bottomSource, &bottomDestination);
+    }
+}
@@ -0,0 +1,273 @@
+// life on a hexagonal grid, where each cell has 6 neighbors. rules are written like B2/S34
+//
+// the hexes are stored in offset rows: odd rows sit half a cell to the right of even ones, so
+// a cell in an even row touches x - 1 and x in the rows above and below it, and a cell in an odd
+// row touches x and x + 1. every row is packed into 64-bit words with bit b of word w holding
+// cell 64w + b, so the neighbors to the left or right of a whole word of cells are the same word
+// shifted by one bit, and counting them is a handful of bitwise adders per 64 cells.
+//
+// live cells are drawn as hexagons from a small texture atlas (one sprite for cells that just
+// came alive, one for cells that survived), all in a single geometry call.
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "cells.h"
+#include "alloc.h"
+#include "bits.h"
+#include "scheduler.h"
+#include "hex.h"
+
+constexpr int HEX_NEIGHBORS = 6;
+
+// the size of each sprite in the atlas, in pixels
+constexpr int SPRITE_SIZE = 16;
+
+// which neighbor counts make a dead cell come alive, and a live cell survive (bit n for n neighbors)
+static int birthCounts = 1 << 2;
+static int survivalCounts = (1 << 3) | (1 << 4);
+
+static int wordsPerRow = 0;
+
+// the board and the next generation, with row y at y * wordsPerRow
+static uint64_t* grid = NULL;
+static uint64_t* nextGrid = NULL;
+
+// the cells that came alive in the last step
+static uint64_t* born = NULL;
+
+// how many cells each row had alive after the last step
+static std::vector<int> rowPopulations;
+
+// the sprites, and the quads drawn with them
+static SDL_Texture* atlas = NULL;
+static std::vector<SDL_Vertex> vertices;
+static std::vector<int> indices;
+
+// sets the rule from something like B2/S34
+// returns false (after logging why) if it can't be read
+bool Parse_Hex_Rule(const char* text)
+{
+    int counts[2] = { 0, 0 };
+    bool seen[2] = { false, false };
+    int half = -1;
+
+    for (int i = 0; text[i] != '\0'; i++) {
+        const char c = (char)SDL_toupper(text[i]);
+
+        if (c == 'B' || c == 'S') {
+            half = (c == 'B') ? 0 : 1;
+            if (seen[half]) half = -1;
+            else seen[half] = true;
+        }
+        else if (c == '/' && half != -1) continue;
+        else if (c >= '0' && c <= '0' + HEX_NEIGHBORS && half != -1) counts[half] |= 1 << (c - '0');
+        else half = -1;
+
+        if (half == -1) {
+            SDL_Log("Couldn't read the hex rule %s (it should look like B2/S34)", text);
+            return false;
+        }
+    }
+
+    if (!seen[0] || !seen[1]) {
+        SDL_Log("Couldn't read the hex rule %s (it should look like B2/S34)", text);
+        return false;
+    }
+
+    birthCounts = counts[0];
+    survivalCounts = counts[1];
+    return true;
+}
+
+// makes room for the board, now that its size is known
+// returns false (after logging why) if it can't be used
+bool Hex_Setup()
+{
+    if (simWidth % 64 != 0 || simHeight % 2 != 0) {
+        SDL_Log("Hex boards need a width that's a multiple of 64 and an even height, e.g. --size 512x256");
+        return false;
+    }
+
+    wordsPerRow = simWidth / 64;
+
+    const size_t bytes = (size_t)wordsPerRow * simHeight * sizeof(uint64_t);
+    grid = (uint64_t*)Allocate_Buffer(bytes, "hex grid");
+    nextGrid = (uint64_t*)Allocate_Buffer(bytes, "next hex grid");
+    born = (uint64_t*)Allocate_Buffer(bytes, "hex births");
+    if (grid == NULL || nextGrid == NULL || born == NULL) return false;
+    SDL_memset(grid, 0, bytes);
+    SDL_memset(born, 0, bytes);
+
+    rowPopulations.assign(simHeight, 0);
+    return true;
+}
+
+// fills the board with random live cells from the given seed, each alive with the given probability
+void Hex_Randomize(float density, Uint64 seed)
+{
+    SDL_srand(seed);
+    for (int y = 0; y < simHeight; y++) {
+        for (int x = 0; x < simWidth; x++) {
+            if (SDL_randf() < density) grid[(size_t)y * wordsPerRow + x / 64] |= 1ull << (x % 64);
+        }
+    }
+    Request_Redraw();
+}
+
+// paints a single live cell
+void Hex_Paint(int x, int y)
+{
+    grid[(size_t)y * wordsPerRow + x / 64] |= 1ull << (x % 64);
+    Request_Redraw();
+}
+
+// the lanes of a 3-bit count whose value is one of the given counts
+static inline uint64_t In_Set(const uint64_t count[3], int counts)
+{
+    uint64_t result = 0;
+    for (int value = 0; value <= HEX_NEIGHBORS; value++) {
+        if (!(counts & (1 << value))) continue;
+
+        uint64_t equal = ~0ull;
+        for (int bit = 0; bit < 3; bit++) equal &= (value >> bit & 1) ? count[bit] : ~count[bit];
+        result |= equal;
+    }
+    return result;
+}
+
+// the cells one to the west (x - 1) of each cell in word w of a row, and one to the east
+static inline uint64_t West(const uint64_t* row, int w)
+{
+    return (row[w] << 1) | (row[(w + wordsPerRow - 1) % wordsPerRow] >> 63);
+}
+
+static inline uint64_t East(const uint64_t* row, int w)
+{
+    return (row[w] >> 1) | (row[(w + 1) % wordsPerRow] << 63);
+}
+
+// steps row `task`
+static void Step_Row(int task, int worker, void* context)
+{
+    const int y = task;
+    const uint64_t* row = grid + (size_t)y * wordsPerRow;
+    const uint64_t* up = grid + (size_t)((y + simHeight - 1) % simHeight) * wordsPerRow;
+    const uint64_t* down = grid + (size_t)((y + 1) % simHeight) * wordsPerRow;
+    uint64_t* output = nextGrid + (size_t)y * wordsPerRow;
+    uint64_t* births = born + (size_t)y * wordsPerRow;
+    const bool oddRow = (y & 1) != 0;
+
+    int live = 0;
+    for (int w = 0; w < wordsPerRow; w++) {
+
+        // even rows touch x - 1 and x above and below, odd rows x and x + 1
+        const uint64_t upSide = oddRow ? East(up, w) : West(up, w);
+        const uint64_t downSide = oddRow ? East(down, w) : West(down, w);
+
+        uint64_t sumA, carryA, sumB, carryB, count[3];
+        Full_Add(West(row, w), East(row, w), up[w], sumA, carryA);
+        Full_Add(upSide, down[w], downSide, sumB, carryB);
+
+        count[0] = sumA ^ sumB;
+        Full_Add(carryA, carryB, sumA & sumB, count[1], count[2]);
+
+        const uint64_t self = row[w];
+        const uint64_t alive = (self & In_Set(count, survivalCounts)) | (~self & In_Set(count, birthCounts));
+
+        output[w] = alive;
+        births[w] = alive & ~self;
+        live += Count_Bits(alive);
+    }
+    rowPopulations[y] = live;
+}
+
+// steps the whole board a generation
+void Hex_Update_Simulation()
+{
+    Scheduler_Run(simHeight, Step_Row, NULL);
+    std::swap(grid, nextGrid);
+    Request_Redraw();
+}
+
+// the number of live cells
+int Hex_Population()
+{
+    int population = 0;
+    for (int live : rowPopulations) population += live;
+    return population;
+}
+
+// a hash of every row
+Uint64 Hex_Hash()
+{
+    return Hash_Bytes(grid, (size_t)wordsPerRow * simHeight * sizeof(uint64_t));
+}
+
+// draws a pointy-topped hexagon into a sprite of the atlas, in the given color
+static void Draw_Sprite(Uint32* pixels, int pitch, int sprite, Uint32 color)
+{
+    const float center = SPRITE_SIZE / 2.0f;
+
+    for (int py = 0; py < SPRITE_SIZE; py++) {
+        for (int px = 0; px < SPRITE_SIZE; px++) {
+            // distance from the center, as a fraction of the hexagon's radius
+            const float dx = SDL_fabsf(px + 0.5f - center) / center;
+            const float dy = SDL_fabsf(py + 0.5f - center) / center;
+
+            // inside the two vertical sides and the four slanted ones
+            const bool inside = dx <= 0.866f && dy <= 1.0f - dx * 0.577f;
+            pixels[py * pitch + sprite * SPRITE_SIZE + px] = inside ? color : 0;
+        }
+    }
+}
+
+// draws the live cells as hexagons
+void Hex_Render(SDL_Renderer* renderer)
+{
+    if (atlas == NULL) {
+        atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, SPRITE_SIZE * 2, SPRITE_SIZE);
+        if (atlas == NULL) return;
+
+        // the survivors are white, the cells that just came alive are green
+        std::vector<Uint32> pixels(SPRITE_SIZE * 2 * SPRITE_SIZE);
+        Draw_Sprite(pixels.data(), SPRITE_SIZE * 2, 0, 0xffffffff);
+        Draw_Sprite(pixels.data(), SPRITE_SIZE * 2, 1, 0xff60ff60);
+
+        SDL_UpdateTexture(atlas, NULL, pixels.data(), SPRITE_SIZE * 2 * (int)sizeof(Uint32));
+        SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    const SDL_FColor white = { 1, 1, 1, 1 };
+
+    for (int y = 0; y < simHeight; y++) {
+        const uint64_t* row = grid + (size_t)y * wordsPerRow;
+        const uint64_t* births = born + (size_t)y * wordsPerRow;
+        const float shift = (y & 1) ? 0.5f : 0.0f;
+
+        for (int w = 0; w < wordsPerRow; w++) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                const uint64_t lowest = bits & (0 - bits);
+                const float x = (float)(w * 64 + Lowest_Bit(bits)) + shift;
+
+                // the left or right half of the atlas
+                const float u = (births[w] & lowest) ? 0.5f : 0.0f;
+
+                const int first = (int)vertices.size();
+                vertices.push_back({ { x, (float)y }, white, { u, 0 } });
+                vertices.push_back({ { x + 1, (float)y }, white, { u + 0.5f, 0 } });
+                vertices.push_back({ { x + 1, (float)y + 1 }, white, { u + 0.5f, 1 } });
+                vertices.push_back({ { x, (float)y + 1 }, white, { u, 1 } });
+
+                const int quad[] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+
+    SDL_RenderGeometry(renderer, atlas, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+}
@@ -0,0 +1,588 @@
+// compiles a rule into native x86-64 code at runtime, so any B/S or MAP rule gets a kernel as
+// specialized as one written by hand, without rebuilding
+//
+// the rule table (512 entries, see rules.cpp) is turned into a reduced ordered binary decision
+// diagram over the 9 cells of the neighborhood, with the cells ordered greedily to keep it small.
+// each node of the diagram picks between two smaller functions depending on one cell, which
+// becomes a few bitwise gates (most nodes have a constant child and need just one). the gates
+// work on 16 cells at once in SSE2 registers: cells are bytes holding 0 or 1, so AND, OR, XOR
+// and AND-NOT on them give 0 or 1 too, and the neighbor cells are just unaligned loads.
+//
+// the gates are given registers in order, neighbor cells included, and when all 14 are in use
+// the value needed furthest in the future is evicted: gates get spilled to the stack and cells
+// are loaded from the grid again later (xmm14 holds the constant 1 and xmm15 is scratch).
+// kernels are cached by rule string, so asking for a rule again doesn't compile it again.
+//
+// only x86-64 is supported (with both the Windows and System V calling conventions). anywhere
+// else Jit_Compile_Rule returns NULL and the table kernel is used.
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CELLS_HAVE_JIT 1
+#endif
+
+#ifdef CELLS_HAVE_JIT
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <initializer_list>
+#include "jit.h"
+
+#ifdef CELLS_HAVE_JIT
+
+// the cells of the neighborhood, and so the inputs of the circuit
+constexpr int CELLS = 9;
+
+// the node numbers of the two constant functions
+constexpr int FALSE_NODE = 0;
+constexpr int TRUE_NODE = 1;
+
+// the registers the gates are given, and the two set aside
+constexpr int GATE_REGISTERS = 14;
+constexpr int ONE_REGISTER = 14;
+constexpr int SCRATCH_REGISTER = 15;
+
+// the general purpose registers the kernel keeps its pointers in
+constexpr int LEFT_BASE = 8; // r8
+constexpr int COLUMN_BASE = 9; // r9
+constexpr int RIGHT_BASE = 10; // r10
+constexpr int OUTPUT_BASE = 11; // r11
+
+// the 16 bytes of 1s the kernel starts with, and where the code itself starts
+constexpr int CONSTANT_BYTES = 16;
+
+// a node of the decision diagram: cell `cell` (a bit of the neighborhood index) picks `high`
+// when alive and `low` when dead
+struct Node {
+    int cell;
+    int low;
+    int high;
+};
+
+enum class GateOp {
+    Cell, // a neighbor (a = its bit of the neighborhood index)
+    One,
+    Zero,
+    And,
+    AndNot, // ~a & b
+    Or,
+    Xor
+};
+
+struct Gate {
+    GateOp op;
+    int a;
+    int b;
+};
+
+// an operand of an SSE2 instruction
+struct Operand {
+    enum Kind { Register, Grid, Stack, Constant } kind;
+    int number; // the xmm register, or the base register of a grid address
+    int offset; // the row offset for a grid address, the byte offset for the stack or constants
+};
+
+// the diagram being built
+static std::vector<Node> nodes;
+static std::map<std::tuple<int, int, int>, int> uniqueNodes;
+
+// the circuit being built
+static std::vector<Gate> gates;
+static std::map<std::tuple<int, int, int>, int> uniqueGates;
+static std::vector<int> nodeGates;
+
+// register allocation for the circuit
+static std::vector<std::vector<int>> gateUses;
+static std::vector<int> gateRegister;
+static std::vector<int> gateSlot;
+static int registerHolder[GATE_REGISTERS];
+static bool registerPinned[GATE_REGISTERS];
+static int slotCount = 0;
+
+// the compiled kernels, and the memory they live in
+static std::unordered_map<std::string, JitKernel> kernels;
+static std::vector<std::pair<void*, size_t>> codeBlocks;
+
+// builds the diagram of the table restricted to the cells before `depth` in `order` having the
+// values in `assigned`, returning its node number
+static int Build_Node(const uint8_t* table, const int* order, int depth, int assigned)
+{
+    if (depth == CELLS) return table[assigned] ? TRUE_NODE : FALSE_NODE;
+
+    const int cell = order[depth];
+    const int low = Build_Node(table, order, depth + 1, assigned);
+    const int high = Build_Node(table, order, depth + 1, assigned | (1 << cell));
+    if (low == high) return low;
+
+    const std::tuple<int, int, int> key(cell, low, high);
+    auto found = uniqueNodes.find(key);
+    if (found != uniqueNodes.end()) return found->second;
+
+    nodes.push_back({ cell, low, high });
+    uniqueNodes[key] = (int)nodes.size() - 1;
+    return (int)nodes.size() - 1;
+}
+
+// builds the whole diagram with the given cell order, returning the root
+static int Build_Diagram(const uint8_t* table, const int* order)
+{
+    nodes.assign(2, { CELLS, 0, 0 });
+    uniqueNodes.clear();
+    return Build_Node(table, order, 0, 0);
+}
+
+// picks the cell order one position at a time, taking whichever cell makes the diagram
+// smallest with the rest left in their usual order
+static void Choose_Order(const uint8_t* table, int* order)
+{
+    bool used[CELLS] = {};
+
+    for (int depth = 0; depth < CELLS; depth++) {
+        int bestCell = -1;
+        size_t bestSize = 0;
+
+        for (int cell = 0; cell < CELLS; cell++) {
+            if (used[cell]) continue;
+
+            int trial[CELLS];
+            int filled = 0;
+            for (int i = 0; i < depth; i++) trial[filled++] = order[i];
+            trial[filled++] = cell;
+            for (int other = 0; other < CELLS; other++) {
+                if (!used[other] && other != cell) trial[filled++] = other;
+            }
+
+            Build_Diagram(table, trial);
+            if (bestCell < 0 || nodes.size() < bestSize) {
+                bestCell = cell;
+                bestSize = nodes.size();
+            }
+        }
+
+        order[depth] = bestCell;
+        used[bestCell] = true;
+    }
+}
+
+// adds a gate, or finds the same one already in the circuit
+static int Add_Gate(GateOp op, int a, int b)
+{
+    // the operands of symmetric gates are put in a fixed order so they match up
+    if ((op == GateOp::And || op == GateOp::Or || op == GateOp::Xor) && a > b) std::swap(a, b);
+
+    const std::tuple<int, int, int> key((int)op, a, b);
+    auto found = uniqueGates.find(key);
+    if (found != uniqueGates.end()) return found->second;
+
+    gates.push_back({ op, a, b });
+    uniqueGates[key] = (int)gates.size() - 1;
+    return (int)gates.size() - 1;
+}
+
+// the gate computing a node of the diagram. nodes with a constant child need one gate (or none),
+// the rest need three
+static int Gate_Of_Node(int node)
+{
+    if (node == FALSE_NODE) return Add_Gate(GateOp::Zero, 0, 0);
+    if (node == TRUE_NODE) return Add_Gate(GateOp::One, 0, 0);
+    if (nodeGates[node] >= 0) return nodeGates[node];
+
+    const Node n = nodes[node];
+    const int cell = Add_Gate(GateOp::Cell, n.cell, 0);
+    int gate;
+
+    if (n.low == FALSE_NODE && n.high == TRUE_NODE) gate = cell;
+    else if (n.low == TRUE_NODE && n.high == FALSE_NODE) gate = Add_Gate(GateOp::Xor, cell, Gate_Of_Node(TRUE_NODE));
+    else if (n.low == FALSE_NODE) gate = Add_Gate(GateOp::And, cell, Gate_Of_Node(n.high));
+    else if (n.high == FALSE_NODE) gate = Add_Gate(GateOp::AndNot, cell, Gate_Of_Node(n.low));
+    else if (n.high == TRUE_NODE) gate = Add_Gate(GateOp::Or, cell, Gate_Of_Node(n.low));
+    else if (n.low == TRUE_NODE) {
+        // dead picks 1, alive picks high: ~(cell & ~high)
+        const int notHigh = Add_Gate(GateOp::AndNot, Gate_Of_Node(n.high), cell);
+        gate = Add_Gate(GateOp::Xor, notHigh, Gate_Of_Node(TRUE_NODE));
+    }
+    else {
+        const int high = Add_Gate(GateOp::And, cell, Gate_Of_Node(n.high));
+        const int low = Add_Gate(GateOp::AndNot, cell, Gate_Of_Node(n.low));
+        gate = Add_Gate(GateOp::Or, high, low);
+    }
+
+    nodeGates[node] = gate;
+    return gate;
+}
+
+static bool Is_Logic(GateOp op)
+{
+    return op == GateOp::And || op == GateOp::AndNot || op == GateOp::Or || op == GateOp::Xor;
+}
+
+static void Emit_Byte(std::vector<uint8_t>& code, int value)
+{
+    code.push_back((uint8_t)value);
+}
+
+static void Emit_Int32(std::vector<uint8_t>& code, int value)
+{
+    for (int i = 0; i < 4; i++) Emit_Byte(code, (value >> (i * 8)) & 0xff);
+}
+
+static void Emit_Bytes(std::vector<uint8_t>& code, std::initializer_list<int> bytes)
+{
+    for (int value : bytes) Emit_Byte(code, value);
+}
+
+// emits an SSE2 instruction: prefix, 0F, opcode, then the xmm register and the other operand.
+// grid addresses are [base + rcx + offset], stack ones [rsp + offset], constants [rip + offset]
+static void Emit_Sse(std::vector<uint8_t>& code, int prefix, int opcode, int xmm, Operand operand)
+{
+    Emit_Byte(code, prefix);
+
+    int rex = 0x40;
+    if (xmm >= 8) rex |= 4;
+    if ((operand.kind == Operand::Register || operand.kind == Operand::Grid) && operand.number >= 8) rex |= 1;
+    if (rex != 0x40) Emit_Byte(code, rex);
+
+    Emit_Byte(code, 0x0f);
+    Emit_Byte(code, opcode);
+
+    const int reg = (xmm & 7) << 3;
+    switch (operand.kind) {
+    case Operand::Register:
+        Emit_Byte(code, 0xc0 | reg | (operand.number & 7));
+        break;
+    case Operand::Grid:
+        Emit_Byte(code, 0x44 | reg); // disp8 with a SIB byte
+        Emit_Byte(code, (1 << 3) | (operand.number & 7)); // index rcx, scale 1
+        Emit_Byte(code, operand.offset & 0xff);
+        break;
+    case Operand::Stack:
+        Emit_Byte(code, 0x84 | reg); // disp32 with a SIB byte
+        Emit_Byte(code, 0x24); // base rsp, no index
+        Emit_Int32(code, operand.offset);
+        break;
+    case Operand::Constant:
+        Emit_Byte(code, 0x05 | reg); // rip relative, from the end of the instruction
+        Emit_Int32(code, operand.offset - ((int)code.size() + 4));
+        break;
+    }
+}
+
+static void Load_Unaligned(std::vector<uint8_t>& code, int xmm, Operand from) { Emit_Sse(code, 0xf3, 0x6f, xmm, from); }
+static void Store_Unaligned(std::vector<uint8_t>& code, int xmm, Operand to) { Emit_Sse(code, 0xf3, 0x7f, xmm, to); }
+static void Load_Aligned(std::vector<uint8_t>& code, int xmm, Operand from) { Emit_Sse(code, 0x66, 0x6f, xmm, from); }
+static void Store_Aligned(std::vector<uint8_t>& code, int xmm, Operand to) { Emit_Sse(code, 0x66, 0x7f, xmm, to); }
+
+static Operand Xmm(int number) { return { Operand::Register, number, 0 }; }
+static Operand Stack_Slot(int slot) { return { Operand::Stack, 0, slot * 16 }; }
+
+// where a neighbor is in the grid: bit 8 of the neighborhood index is NW, down to SE at bit 0
+static Operand Cell_Address(int cell)
+{
+    static const int BASES[3] = { RIGHT_BASE, COLUMN_BASE, LEFT_BASE };
+    return { Operand::Grid, BASES[cell % 3], 1 - cell / 3 };
+}
+
+// whether a gate's value is kept in a register between uses (constants are always at hand)
+static bool Is_Held(GateOp op)
+{
+    return op == GateOp::Cell || Is_Logic(op);
+}
+
+// the first use of a gate after gate `now`
+static int Next_Use(int gate, int now)
+{
+    for (int use : gateUses[gate]) {
+        if (use > now) return use;
+    }
+    return INT_MAX;
+}
+
+// whether a gate's value sits in a register and gate `now` is the last to use it
+static bool Dies_In_Register(int gate, int now)
+{
+    return Is_Held(gates[gate].op) && gateRegister[gate] >= 0 && gateUses[gate].back() == now;
+}
+
+// frees a register, evicting whichever value in it is needed furthest in the future. evicted
+// gates are spilled to the stack, but neighbor cells can just be loaded from the grid again
+static int Allocate_Register(std::vector<uint8_t>& code, int now)
+{
+    for (int r = 0; r < GATE_REGISTERS; r++) {
+        if (registerHolder[r] < 0 && !registerPinned[r]) return r;
+    }
+
+    int victim = -1;
+    int furthest = -1;
+    for (int r = 0; r < GATE_REGISTERS; r++) {
+        if (registerPinned[r]) continue;
+
+        const int use = Next_Use(registerHolder[r], now);
+        if (use > furthest) {
+            furthest = use;
+            victim = r;
+        }
+    }
+
+    const int gate = registerHolder[victim];
+    if (Is_Logic(gates[gate].op) && gateSlot[gate] < 0) {
+        gateSlot[gate] = slotCount++;
+        Store_Aligned(code, victim, Stack_Slot(gateSlot[gate]));
+    }
+    gateRegister[gate] = -1;
+    registerHolder[victim] = -1;
+    return victim;
+}
+
+// copies a gate's value into a register
+static void Load_Gate(std::vector<uint8_t>& code, int xmm, int gate)
+{
+    const Gate& g = gates[gate];
+    if (g.op == GateOp::One) Load_Aligned(code, xmm, Xmm(ONE_REGISTER));
+    else if (g.op == GateOp::Zero) Emit_Sse(code, 0x66, 0xef, xmm, Xmm(xmm));
+    else if (gateRegister[gate] >= 0) Load_Aligned(code, xmm, Xmm(gateRegister[gate]));
+    else if (g.op == GateOp::Cell) Load_Unaligned(code, xmm, Cell_Address(g.a));
+    else Load_Aligned(code, xmm, Stack_Slot(gateSlot[gate]));
+}
+
+// where a gate's value can be read from as the second operand of an instruction. neighbor
+// cells that will be used again get a register of their own
+static Operand Source_Of(std::vector<uint8_t>& code, int gate, int now)
+{
+    const Gate& g = gates[gate];
+    if (g.op == GateOp::One) return Xmm(ONE_REGISTER);
+    if (Is_Held(g.op) && gateRegister[gate] >= 0) return Xmm(gateRegister[gate]);
+    if (Is_Logic(g.op)) return Stack_Slot(gateSlot[gate]);
+
+    if (g.op == GateOp::Cell && gateUses[gate].back() > now) {
+        const int r = Allocate_Register(code, now);
+        Load_Gate(code, r, gate);
+        registerHolder[r] = gate;
+        gateRegister[gate] = r;
+        return Xmm(r);
+    }
+
+    Load_Gate(code, SCRATCH_REGISTER, gate);
+    return Xmm(SCRATCH_REGISTER);
+}
+
+// lets go of a gate's register if gate `now` was its last use
+static void Release(int gate, int now)
+{
+    if (!Is_Held(gates[gate].op) || gateUses[gate].back() != now) return;
+
+    if (gateRegister[gate] >= 0 && registerHolder[gateRegister[gate]] == gate) registerHolder[gateRegister[gate]] = -1;
+    gateRegister[gate] = -1;
+}
+
+// emits the loop body: every gate for 16 cells, then the store of the output gate
+static void Emit_Circuit(std::vector<uint8_t>& code, int output)
+{
+    const int count = (int)gates.size();
+
+    gateUses.assign(count, std::vector<int>());
+    for (int g = 0; g < count; g++) {
+        if (!Is_Logic(gates[g].op)) continue;
+        gateUses[gates[g].a].push_back(g);
+        gateUses[gates[g].b].push_back(g);
+    }
+    gateUses[output].push_back(count);
+
+    gateRegister.assign(count, -1);
+    gateSlot.assign(count, -1);
+    for (int r = 0; r < GATE_REGISTERS; r++) {
+        registerHolder[r] = -1;
+        registerPinned[r] = false;
+    }
+    slotCount = 0;
+
+    for (int g = 0; g < count; g++) {
+        const GateOp op = gates[g].op;
+        if (!Is_Logic(op) || gateUses[g].empty()) continue;
+
+        int a = gates[g].a;
+        int b = gates[g].b;
+
+        // the first operand gets overwritten, so for symmetric gates it should be one that's done with
+        if (op != GateOp::AndNot && Dies_In_Register(b, g) && !Dies_In_Register(a, g)) std::swap(a, b);
+
+        // nothing this gate reads can be evicted while it's being computed
+        if (gateRegister[a] >= 0) registerPinned[gateRegister[a]] = true;
+        if (gateRegister[b] >= 0) registerPinned[gateRegister[b]] = true;
+
+        int destination;
+        if (Dies_In_Register(a, g)) {
+            destination = gateRegister[a];
+            registerHolder[destination] = -1;
+            gateRegister[a] = -1;
+        }
+        else {
+            destination = Allocate_Register(code, g);
+            Load_Gate(code, destination, a);
+        }
+        registerPinned[destination] = true;
+
+        static const int OPCODES[] = { 0, 0, 0, 0xdb, 0xdf, 0xeb, 0xef }; // pand, pandn, por, pxor
+        Emit_Sse(code, 0x66, OPCODES[(int)op], destination, Source_Of(code, b, g));
+
+        Release(a, g);
+        Release(b, g);
+        registerHolder[destination] = g;
+        gateRegister[g] = destination;
+        for (int r = 0; r < GATE_REGISTERS; r++) registerPinned[r] = false;
+    }
+
+    const Operand store = { Operand::Grid, OUTPUT_BASE, 0 };
+    if (Is_Held(gates[output].op) && gateRegister[output] >= 0) {
+        Store_Unaligned(code, gateRegister[output], store);
+    }
+    else {
+        Load_Gate(code, SCRATCH_REGISTER, output);
+        Store_Unaligned(code, SCRATCH_REGISTER, store);
+    }
+}
+
+// puts the code in memory that can be executed (but not written)
+static void* Make_Executable(const std::vector<uint8_t>& code)
+{
+#ifdef _WIN32
+    void* memory = VirtualAlloc(NULL, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (memory == NULL) return NULL;
+    SDL_memcpy(memory, code.data(), code.size());
+
+    DWORD previous;
+    if (!VirtualProtect(memory, code.size(), PAGE_EXECUTE_READ, &previous)) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return NULL;
+    }
+    FlushInstructionCache(GetCurrentProcess(), memory, code.size());
+#else
+    void* memory = mmap(NULL, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return NULL;
+    SDL_memcpy(memory, code.data(), code.size());
+
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, code.size());
+        return NULL;
+    }
+#endif
+
+    codeBlocks.push_back({ memory, code.size() });
+    return memory;
+}
+
+// compiles a rule table (512 entries, indexed as in rules.cpp) into a kernel, or returns the one
+// already compiled for the same rule string. returns NULL (after logging why) if it can't
+JitKernel Jit_Compile_Rule(const char* name, const uint8_t* table)
+{
+    auto found = kernels.find(name);
+    if (found != kernels.end()) return found->second;
+
+    int order[CELLS];
+    Choose_Order(table, order);
+    const int root = Build_Diagram(table, order);
+
+    gates.clear();
+    uniqueGates.clear();
+    nodeGates.assign(nodes.size(), -1);
+    const int output = Gate_Of_Node(root);
+
+    std::vector<uint8_t> body;
+    Emit_Circuit(body, output);
+
+#ifdef _WIN32
+    // xmm6 to xmm15 belong to the caller on windows, so they're saved above the spill slots
+    const int savedRegisters = 10;
+    const int argumentRegister = 1; // rcx
+#else
+    const int savedRegisters = 0;
+    const int argumentRegister = 7; // rdi
+#endif
+    const int saveOffset = slotCount * 16;
+    const int frame = saveOffset + savedRegisters * 16 + 8; // keeps rsp 16 byte aligned
+
+    std::vector<uint8_t> code(CONSTANT_BYTES, 1);
+
+    Emit_Bytes(code, { 0x48, 0x81, 0xec }); // sub rsp, frame
+    Emit_Int32(code, frame);
+    for (int i = 0; i < savedRegisters; i++) Store_Unaligned(code, 6 + i, { Operand::Stack, 0, saveOffset + i * 16 });
+
+    Emit_Bytes(code, { 0x48, 0x89, 0xc0 | (argumentRegister << 3) }); // mov rax, the JitColumn
+    Emit_Bytes(code, { 0x4c, 0x8b, 0x40, 0x00 }); // mov r8, left
+    Emit_Bytes(code, { 0x4c, 0x8b, 0x48, 0x08 }); // mov r9, column
+    Emit_Bytes(code, { 0x4c, 0x8b, 0x50, 0x10 }); // mov r10, right
+    Emit_Bytes(code, { 0x4c, 0x8b, 0x58, 0x18 }); // mov r11, output
+    Emit_Bytes(code, { 0x48, 0x8b, 0x50, 0x20 }); // mov rdx, bytes
+    Emit_Bytes(code, { 0x31, 0xc9 }); // xor ecx, ecx
+    Load_Aligned(code, ONE_REGISTER, { Operand::Constant, 0, 0 });
+
+    const int loop = (int)code.size();
+    code.insert(code.end(), body.begin(), body.end());
+    Emit_Bytes(code, { 0x48, 0x83, 0xc1, 0x10 }); // add rcx, 16
+    Emit_Bytes(code, { 0x48, 0x39, 0xd1 }); // cmp rcx, rdx
+    Emit_Bytes(code, { 0x0f, 0x82 }); // jb loop
+    Emit_Int32(code, loop - ((int)code.size() + 4));
+
+    for (int i = 0; i < savedRegisters; i++) Load_Unaligned(code, 6 + i, { Operand::Stack, 0, saveOffset + i * 16 });
+    Emit_Bytes(code, { 0x48, 0x81, 0xc4 }); // add rsp, frame
+    Emit_Int32(code, frame);
+    Emit_Byte(code, 0xc3); // ret
+
+    uint8_t* memory = (uint8_t*)Make_Executable(code);
+    if (memory == NULL) {
+        SDL_Log("Couldn't get executable memory for the compiled rule %s", name);
+        return NULL;
+    }
+
+    int logicGates = 0;
+    for (int g = 0; g < (int)gates.size(); g++) {
+        if (Is_Logic(gates[g].op) && !gateUses[g].empty()) logicGates++;
+    }
+    SDL_Log("compiled %s: %d decision nodes, %d gates, %d spill slots, %d bytes of code",
+        name, (int)nodes.size() - 2, logicGates, slotCount, (int)code.size());
+
+    const JitKernel kernel = (JitKernel)(memory + CONSTANT_BYTES);
+    kernels[name] = kernel;
+    return kernel;
+}
+
+// frees every compiled kernel
+void Jit_Release()
+{
+    for (const std::pair<void*, size_t>& block : codeBlocks) {
+#ifdef _WIN32
+        VirtualFree(block.first, 0, MEM_RELEASE);
+#else
+        munmap(block.first, block.second);
+#endif
+    }
+    codeBlocks.clear();
+    kernels.clear();
+}
+
+#else
+
+JitKernel Jit_Compile_Rule(const char* name, const uint8_t* table)
+{
+    SDL_Log("Rules can only be compiled on x86-64, so %s will use the table kernel", name);
+    (void)table;
+    return NULL;
+}
+
+void Jit_Release()
+{
+}
+
+#endif
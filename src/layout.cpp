@@ -0,0 +1,66 @@
+// sets up the memory layout of the grid (see layout.h)
+
+#include "layout.h"
+
+GridLayout gridLayout = GridLayout::Linear;
+
+int gridStride = 0;
+
+int mortonBitsX = 0;
+int mortonBitsY = 0;
+
+// the number of bits needed to count up to n - 1
+static int Bits_For(int n) {
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    return bits;
+}
+
+// packs the even bits of x back together (0a0b0c0d -> abcd), undoing Spread_Bits
+static uint32_t Compact_Bits(uint64_t x) {
+    x &= 0x5555555555555555ull;
+    x = (x | (x >> 1)) & 0x3333333333333333ull;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+    return (uint32_t)x;
+}
+
+// picks the layout for a board of simWidth x simHeight
+// a stride of 0 rounds the rows up to whole cache lines, so every row starts on one
+void Setup_Layout(GridLayout layout, int stride) {
+    gridLayout = layout;
+    gridStride = (stride > 0) ? stride : (simWidth + 63) / 64 * 64;
+    mortonBitsX = Bits_For((simWidth + MORTON_TILE_SIZE - 1) / MORTON_TILE_SIZE);
+    mortonBitsY = Bits_For((simHeight + MORTON_TILE_SIZE - 1) / MORTON_TILE_SIZE);
+}
+
+// the number of morton tiles, including the padding tiles past the edges of the board
+size_t Morton_Tile_Count() {
+    return (size_t)1 << (mortonBitsX + mortonBitsY);
+}
+
+// the number of cells the grid buffers need to hold.
+// the morton layout rounds both sides up to a power of two tiles, so it can use up to 4x more,
+// and the row-major layout pads each row out to the stride
+size_t Grid_Cell_Count() {
+    if (gridLayout == GridLayout::Morton) return Morton_Tile_Count() * MORTON_TILE_CELLS;
+    if (gridLayout == GridLayout::RowMajor) return (size_t)gridStride * simHeight;
+    return (size_t)simWidth * simHeight;
+}
+
+// finds the tile coordinates of the tile at the given Z-order position
+// returns false if it is a padding tile that lies past the edge of the board
+bool Morton_Tile_Position(size_t index, int* tx, int* ty) {
+    const int shared = mortonBitsX < mortonBitsY ? mortonBitsX : mortonBitsY;
+    const uint64_t low = (uint64_t)index & ((1ull << (2 * shared)) - 1);
+    const uint64_t high = (uint64_t)index >> (2 * shared);
+
+    *tx = (int)Compact_Bits(low);
+    *ty = (int)Compact_Bits(low >> 1);
+    if (mortonBitsX > mortonBitsY) *tx |= (int)(high << shared);
+    else *ty |= (int)(high << shared);
+
+    return *tx * MORTON_TILE_SIZE < simWidth && *ty * MORTON_TILE_SIZE < simHeight;
+}
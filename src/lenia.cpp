@@ -0,0 +1,409 @@
+// Lenia: every cell holds a value from 0 to 1 instead of being alive or dead. each step, the
+// field is blurred with a ring-shaped kernel (a weighted average over a radius of R cells), and
+// each cell grows or shrinks depending on how close that average is to mu:
+//   A = clamp(A + dt * (2 * exp(-(U - mu)^2 / (2 sigma^2)) - 1), 0, 1), where U = K * A
+//
+// with a radius in the tens of cells, a direct stencil would be thousands of multiplies per
+// cell, so the blur is done as a multiply in the frequency domain instead. the FFT wraps around
+// at the edges exactly like the rest of the simulation does.
+//
+// the field is real, so the transform along each column is a real FFT: two columns go through
+// one complex FFT (one as the real part, one as the imaginary part) and get pulled apart after,
+// and only the H/2 + 1 non-negative frequencies are kept. the transforms along rows then only
+// have to cover those. every batch of transforms is split into tasks for the scheduler.
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <vector>
+#include "cells.h"
+#include "alloc.h"
+#include "scheduler.h"
+#include "lenia.h"
+
+constexpr double PI = 3.14159265358979323846;
+
+// how many columns each task transforms. 8 complex values fill a cache line, so writing a row of
+// the spectrum doesn't share lines between tasks
+constexpr int COLUMNS_PER_TASK = 8;
+
+struct Complex {
+    float re, im;
+};
+
+// a radix-2 FFT of one size
+struct FFTPlan {
+    int size = 0;
+    std::vector<Complex> twiddles; // exp(-2 pi i k / size), for k < size / 2
+    std::vector<int> reversed; // where each element goes in the bit-reversed order
+};
+
+// the parameters of the rule. the defaults are Orbium, the best known Lenia glider
+static int radius = 13;
+static float mu = 0.15f;
+static float sigma = 0.015f;
+static float dt = 0.1f;
+
+// the growth function sampled across averages from 0 to 1, since exp is slow. with sigma at
+// 0.015 that's still about 60 samples across the peak
+constexpr int GROWTH_STEPS = 4096;
+static float growthTable[GROWTH_STEPS + 2];
+
+// the value of every cell, at x * simHeight + y like the linear layout
+static float* field = NULL;
+
+// the transformed field and kernel, holding frequency v of column x at v * simWidth + x
+static Complex* spectrum = NULL;
+static Complex* kernelSpectrum = NULL;
+static int frequencies = 0; // simHeight / 2 + 1
+
+static FFTPlan columnPlan; // for transforms down a column (simHeight long)
+static FFTPlan rowPlan; // for transforms across a row (simWidth long)
+
+// room for a task's worth of columns, for each worker
+static std::vector<std::vector<Complex>> scratch;
+
+// how many cells each task found above zero
+static std::vector<int> taskPopulations;
+static int population = 0;
+
+// the texture the field is drawn through, and the colors it's drawn in
+static SDL_Texture* texture = NULL;
+static std::vector<Uint32> pixels;
+static Uint32 colormap[256];
+
+// sets the rule, either by name or as radius,mu,sigma,dt
+// returns false (after logging why) if it can't be read
+bool Parse_Lenia_Parameters(const char* text)
+{
+    if (SDL_strcmp(text, "orbium") == 0) return true;
+
+    if (SDL_sscanf(text, "%d,%f,%f,%f", &radius, &mu, &sigma, &dt) != 4 || radius < 2 || sigma <= 0 || dt <= 0) {
+        SDL_Log("Couldn't read the Lenia parameters %s (they should be orbium, or radius,mu,sigma,dt like 13,0.15,0.015,0.1, with a radius of at least 2)", text);
+        return false;
+    }
+    return true;
+}
+
+static bool Is_Power_Of_Two(int n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+static void Setup_Plan(FFTPlan& plan, int size)
+{
+    plan.size = size;
+
+    plan.twiddles.resize(size / 2);
+    for (int k = 0; k < size / 2; k++) {
+        const double angle = -2.0 * PI * k / size;
+        plan.twiddles[k] = { (float)cos(angle), (float)sin(angle) };
+    }
+
+    int bits = 0;
+    while ((1 << bits) < size) bits++;
+
+    plan.reversed.resize(size);
+    for (int i = 0; i < size; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        }
+        plan.reversed[i] = r;
+    }
+}
+
+// transforms data in place. the inverse isn't scaled, so a round trip multiplies by the size
+static void FFT(const FFTPlan& plan, Complex* data, bool inverse)
+{
+    const int n = plan.size;
+
+    for (int i = 0; i < n; i++) {
+        const int r = plan.reversed[i];
+        if (i < r) std::swap(data[i], data[r]);
+    }
+
+    const float direction = inverse ? -1.0f : 1.0f;
+
+    for (int length = 2; length <= n; length *= 2) {
+        const int half = length / 2;
+        const int stride = n / length;
+
+        // each twiddle is loaded once per pass, and used on every block of the pass
+        for (int k = 0; k < half; k++) {
+            const float wr = plan.twiddles[k * stride].re;
+            const float wi = plan.twiddles[k * stride].im * direction;
+
+            for (int start = k; start < n; start += length) {
+                Complex& a = data[start];
+                Complex& b = data[start + half];
+
+                const float tr = b.re * wr - b.im * wi;
+                const float ti = b.re * wi + b.im * wr;
+
+                b.re = a.re - tr;
+                b.im = a.im - ti;
+                a.re += tr;
+                a.im += ti;
+            }
+        }
+    }
+}
+
+// transforms the columns of one task from the field into the spectrum
+static void Forward_Columns(int task, int worker, void* context)
+{
+    const int firstColumn = task * COLUMNS_PER_TASK;
+
+    for (int pair = 0; pair < COLUMNS_PER_TASK / 2; pair++) {
+        Complex* buffer = scratch[worker].data() + (size_t)pair * simHeight;
+        const float* a = field + (size_t)(firstColumn + pair * 2) * simHeight;
+        const float* b = a + simHeight;
+
+        for (int y = 0; y < simHeight; y++) buffer[y] = { a[y], b[y] };
+        FFT(columnPlan, buffer, false);
+    }
+
+    // the transform of a real column is symmetric (frequency H - v is the conjugate of v),
+    // which is what lets the two columns be separated again. all of the task's columns are
+    // written together, so each row of the spectrum gets a whole cache line at a time
+    for (int v = 0; v < frequencies; v++) {
+        Complex* out = spectrum + (size_t)v * simWidth + firstColumn;
+
+        for (int pair = 0; pair < COLUMNS_PER_TASK / 2; pair++) {
+            const Complex* buffer = scratch[worker].data() + (size_t)pair * simHeight;
+            const Complex z = buffer[v];
+            const Complex mirror = buffer[(simHeight - v) & (simHeight - 1)];
+
+            out[pair * 2] = { (z.re + mirror.re) * 0.5f, (z.im - mirror.im) * 0.5f };
+            out[pair * 2 + 1] = { (z.im + mirror.im) * 0.5f, (mirror.re - z.re) * 0.5f };
+        }
+    }
+}
+
+// finishes transforming the kernel, one frequency row at a time
+static void Transform_Kernel_Row(int task, int worker, void* context)
+{
+    FFT(rowPlan, kernelSpectrum + (size_t)task * simWidth, false);
+}
+
+// transforms frequency row `task` across the board, multiplies it by the kernel (which blurs the
+// field) and transforms it back
+static void Convolve_Row(int task, int worker, void* context)
+{
+    Complex* row = spectrum + (size_t)task * simWidth;
+
+    FFT(rowPlan, row, false);
+
+    const Complex* kernelRow = kernelSpectrum + (size_t)task * simWidth;
+    for (int x = 0; x < simWidth; x++) {
+        const Complex a = row[x];
+        const Complex k = kernelRow[x];
+        row[x] = { a.re * k.re - a.im * k.im, a.re * k.im + a.im * k.re };
+    }
+
+    FFT(rowPlan, row, true);
+}
+
+// transforms the columns of one task back, and grows the field from the result
+static void Inverse_Columns_And_Grow(int task, int worker, void* context)
+{
+    const int firstColumn = task * COLUMNS_PER_TASK;
+    const float scale = 1.0f / ((float)simWidth * simHeight);
+
+    // put each pair of spectra back together as a + ib, filling in the negative frequencies
+    // from the symmetry
+    for (int v = 0; v < simHeight; v++) {
+        const bool mirrored = v >= frequencies;
+        const Complex* in = spectrum + (size_t)(mirrored ? simHeight - v : v) * simWidth + firstColumn;
+
+        for (int pair = 0; pair < COLUMNS_PER_TASK / 2; pair++) {
+            Complex a = in[pair * 2];
+            Complex b = in[pair * 2 + 1];
+            if (mirrored) {
+                a.im = -a.im;
+                b.im = -b.im;
+            }
+            scratch[worker][(size_t)pair * simHeight + v] = { a.re - b.im, a.im + b.re };
+        }
+    }
+
+    int live = 0;
+    for (int pair = 0; pair < COLUMNS_PER_TASK / 2; pair++) {
+        Complex* buffer = scratch[worker].data() + (size_t)pair * simHeight;
+        FFT(columnPlan, buffer, true);
+
+        for (int column = 0; column < 2; column++) {
+            float* cells = field + (size_t)(firstColumn + pair * 2 + column) * simHeight;
+
+            for (int y = 0; y < simHeight; y++) {
+                // the average is always between 0 and 1, apart from rounding
+                const float average = (column == 0 ? buffer[y].re : buffer[y].im) * scale;
+                const float position = SDL_clamp(average, 0.0f, 1.0f) * GROWTH_STEPS;
+                const int step = SDL_clamp((int)position, 0, GROWTH_STEPS); // clamped again, in case a NaN got past the first one
+                const float growth = growthTable[step] + (position - step) * (growthTable[step + 1] - growthTable[step]);
+
+                const float value = SDL_clamp(cells[y] + dt * growth, 0.0f, 1.0f);
+                cells[y] = value;
+                live += value > 0;
+            }
+        }
+    }
+    taskPopulations[task] = live;
+}
+
+// makes room for the field and works out the kernel, now that the board size is known
+// returns false (after logging why) if the board can't be used
+bool Lenia_Setup()
+{
+    if (!Is_Power_Of_Two(simWidth) || !Is_Power_Of_Two(simHeight) || simWidth < COLUMNS_PER_TASK || simHeight < 4) {
+        SDL_Log("Lenia needs a board whose width and height are powers of two, e.g. --size 512x256");
+        return false;
+    }
+
+    // otherwise the kernel would wrap around onto itself
+    if (2 * radius >= SDL_min(simWidth, simHeight)) {
+        SDL_Log("A Lenia radius of %d needs a board more than %d cells across each way", radius, 2 * radius);
+        return false;
+    }
+
+    frequencies = simHeight / 2 + 1;
+    const size_t cells = (size_t)simWidth * simHeight;
+    field = (float*)Allocate_Buffer(cells * sizeof(float), "lenia field");
+    spectrum = (Complex*)Allocate_Buffer((size_t)frequencies * simWidth * sizeof(Complex), "lenia spectrum");
+    kernelSpectrum = (Complex*)Allocate_Buffer((size_t)frequencies * simWidth * sizeof(Complex), "lenia kernel");
+    if (field == NULL || spectrum == NULL || kernelSpectrum == NULL) return false;
+
+    Setup_Plan(columnPlan, simHeight);
+    Setup_Plan(rowPlan, simWidth);
+
+    scratch.assign(Scheduler_Worker_Count(), std::vector<Complex>((size_t)simHeight * COLUMNS_PER_TASK / 2));
+    taskPopulations.assign(simWidth / COLUMNS_PER_TASK, 0);
+
+    // the kernel is a smooth ring, centered on cell 0,0 and wrapping around the edges, that adds
+    // up to 1. it's built in the field buffer, which is still empty
+    double total = 0;
+    for (int x = 0; x < simWidth; x++) {
+        const int dx = SDL_min(x, simWidth - x);
+        for (int y = 0; y < simHeight; y++) {
+            const int dy = SDL_min(y, simHeight - y);
+            const double r = sqrt((double)dx * dx + (double)dy * dy) / radius;
+
+            double weight = 0;
+            if (r > 0 && r < 1) weight = exp(4.0 - 1.0 / (r * (1.0 - r)));
+
+            field[(size_t)x * simHeight + y] = (float)weight;
+            total += weight;
+        }
+    }
+    if (total <= 0) {
+        SDL_Log("A Lenia radius of %d leaves the kernel empty", radius);
+        return false;
+    }
+    for (size_t i = 0; i < cells; i++) field[i] = (float)(field[i] / total);
+
+    Scheduler_Run(simWidth / COLUMNS_PER_TASK, Forward_Columns, NULL);
+    SDL_memcpy(kernelSpectrum, spectrum, (size_t)frequencies * simWidth * sizeof(Complex));
+    Scheduler_Run(frequencies, Transform_Kernel_Row, NULL);
+    SDL_memset(field, 0, cells * sizeof(float));
+
+    for (int i = 0; i < GROWTH_STEPS + 2; i++) {
+        const double distance = ((double)i / GROWTH_STEPS - mu) / sigma;
+        growthTable[i] = (float)(2.0 * exp(-0.5 * distance * distance) - 1.0);
+    }
+
+    // black through blue and green to yellow
+    static const float STOPS[][4] = {
+        { 0.00f, 0, 0, 0 }, { 0.25f, 40, 20, 110 }, { 0.50f, 30, 140, 140 },
+        { 0.75f, 120, 210, 80 }, { 1.00f, 250, 230, 40 }
+    };
+    for (int i = 0; i < 256; i++) {
+        const float t = i / 255.0f;
+        int s = 0;
+        while (s < 3 && t > STOPS[s + 1][0]) s++;
+
+        const float f = (t - STOPS[s][0]) / (STOPS[s + 1][0] - STOPS[s][0]);
+        Uint32 color = 0xff000000;
+        for (int c = 0; c < 3; c++) {
+            const int channel = (int)(STOPS[s][c + 1] + f * (STOPS[s + 1][c + 1] - STOPS[s][c + 1]));
+            color |= (Uint32)channel << (16 - 8 * c);
+        }
+        colormap[i] = color;
+    }
+    return true;
+}
+
+// fills the field with random values from the given seed, each cell nonzero with the given probability
+void Lenia_Randomize(float density, Uint64 seed)
+{
+    SDL_srand(seed);
+    for (size_t i = 0; i < (size_t)simWidth * simHeight; i++) {
+        field[i] = SDL_randf() < density ? SDL_randf() : 0.0f;
+    }
+    Request_Redraw();
+}
+
+// paints a blob of random values, big enough to start something growing
+void Lenia_Paint(int x, int y)
+{
+    const int brush = SDL_max(1, radius / 2);
+
+    for (int dx = -brush; dx <= brush; dx++) {
+        for (int dy = -brush; dy <= brush; dy++) {
+            if (dx * dx + dy * dy > brush * brush) continue;
+
+            const int nx = (x + dx + simWidth) % simWidth;
+            const int ny = (y + dy + simHeight) % simHeight;
+            float& cell = field[(size_t)nx * simHeight + ny];
+            cell = SDL_max(cell, SDL_randf());
+        }
+    }
+    Request_Redraw();
+}
+
+// steps the field forward by dt
+void Lenia_Update_Simulation()
+{
+    Scheduler_Run(simWidth / COLUMNS_PER_TASK, Forward_Columns, NULL);
+    Scheduler_Run(frequencies, Convolve_Row, NULL);
+    Scheduler_Run(simWidth / COLUMNS_PER_TASK, Inverse_Columns_And_Grow, NULL);
+
+    population = 0;
+    for (int live : taskPopulations) population += live;
+
+    Request_Redraw();
+}
+
+// the number of cells above zero
+int Lenia_Population()
+{
+    return population;
+}
+
+// a hash of the field's exact values
+Uint64 Lenia_Hash()
+{
+    return Hash_Bytes(field, (size_t)simWidth * simHeight * sizeof(float));
+}
+
+// draws the field through the colormap, by uploading it as a texture
+void Lenia_Render(SDL_Renderer* renderer)
+{
+    if (texture == NULL) {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, simWidth, simHeight);
+        if (texture == NULL) return;
+        SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+        pixels.resize((size_t)simWidth * simHeight);
+    }
+
+    for (int x = 0; x < simWidth; x++) {
+        const float* cells = field + (size_t)x * simHeight;
+        for (int y = 0; y < simHeight; y++) {
+            pixels[(size_t)y * simWidth + x] = colormap[(int)(cells[y] * 255.0f)];
+        }
+    }
+
+    SDL_UpdateTexture(texture, NULL, pixels.data(), simWidth * (int)sizeof(Uint32));
+
+    const SDL_FRect destination = { 0, 0, (float)simWidth, (float)simHeight };
+    SDL_RenderTexture(renderer, texture, NULL, &destination);
+}
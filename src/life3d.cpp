@@ -0,0 +1,291 @@
+// 3D life: the board is a stack of `depth` slices, wrapping around on all three axes, and each
+// cell has 26 neighbors. rules are written the way Carter Bays wrote them, e.g. 4555: a live cell
+// survives with 4 to 5 live neighbors, and a dead cell comes alive with 5 to 5.
+//
+// a 512x512x512 volume is 128M cells, so each cell is a single bit. every row along x is packed
+// into 64-bit words, and the kernel works out the neighbor counts of 64 cells at once with
+// bitwise adders (each count is spread across 5 words, one per bit):
+//   1. the 9 rows around a row (above, below, in front and behind) are added up into a count of
+//      the live cells in each 3x3 column through the row
+//   2. each column count is added to the counts to its left and right (which are the same words
+//      shifted by a bit), giving the live cells in the 3x3x3 cube around each cell
+// slices are stepped in parallel on the scheduler. the 2D view shows one slice at a time (up and
+// down move through them), or every slice at once squashed along z (toggled with P).
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "cells.h"
+#include "alloc.h"
+#include "bits.h"
+#include "scheduler.h"
+#include "life3d.h"
+
+// the most neighbors a cell can have
+constexpr int MAX_NEIGHBORS_3D = 26;
+
+// Bays' four numbers: survival from surviveLow to surviveHigh, birth from birthLow to birthHigh
+static int surviveLow = 4, surviveHigh = 5, birthLow = 5, birthHigh = 5;
+
+static int depth = 0;
+static int wordsPerRow = 0;
+
+// the volume and the next generation, holding row y of slice z at (z * simHeight + y) * wordsPerRow
+static uint64_t* volume = NULL;
+static uint64_t* nextVolume = NULL;
+
+// the slice being shown, and whether all of them are shown at once instead
+static int viewSlice = 0;
+static bool projection = false;
+
+// how many cells each slice had alive after the last step
+static std::vector<int> slicePopulations;
+
+// sets the rule from four numbers, either written together (4555) or with commas (4,5,5,5)
+// returns false (after logging why) if it can't be read
+bool Parse_Life3D_Rule(const char* text)
+{
+    int values[4];
+    bool parsed = SDL_sscanf(text, "%d,%d,%d,%d", &values[0], &values[1], &values[2], &values[3]) == 4;
+
+    if (!parsed && SDL_strlen(text) == 4) {
+        parsed = true;
+        for (int i = 0; i < 4; i++) {
+            if (text[i] < '0' || text[i] > '9') parsed = false;
+            values[i] = text[i] - '0';
+        }
+    }
+
+    for (int i = 0; i < 4 && parsed; i++) {
+        if (values[i] < 0 || values[i] > MAX_NEIGHBORS_3D) parsed = false;
+    }
+
+    if (!parsed) {
+        SDL_Log("Couldn't read the 3D rule %s (it should look like 4555 or 5,7,6,6)", text);
+        return false;
+    }
+
+    surviveLow = values[0];
+    surviveHigh = values[1];
+    birthLow = values[2];
+    birthHigh = values[3];
+    return true;
+}
+
+static inline uint64_t* Row(uint64_t* grid, int y, int z)
+{
+    return grid + ((size_t)z * simHeight + y) * wordsPerRow;
+}
+
+// makes room for the volume, now that its size is known
+// returns false (after logging why) if it can't be used
+bool Life3D_Setup(int sliceCount)
+{
+    if (simWidth % 64 != 0 || sliceCount < 3) {
+        SDL_Log("3D boards need a width that's a multiple of 64 and a depth of at least 3, e.g. --size 512x512 --depth 512");
+        return false;
+    }
+
+    depth = sliceCount;
+    wordsPerRow = simWidth / 64;
+
+    const size_t bytes = (size_t)wordsPerRow * simHeight * depth * sizeof(uint64_t);
+    volume = (uint64_t*)Allocate_Buffer(bytes, "3d grid");
+    nextVolume = (uint64_t*)Allocate_Buffer(bytes, "next 3d grid");
+    if (volume == NULL || nextVolume == NULL) return false;
+    SDL_memset(volume, 0, bytes);
+
+    slicePopulations.assign(depth, 0);
+    viewSlice = depth / 2;
+    return true;
+}
+
+// fills the view's render buffer with the slice being shown, or the projection of all of them
+static void Build_View()
+{
+    static std::vector<uint64_t> row;
+    row.resize(wordsPerRow);
+
+    Clear_Rendered_Points();
+
+    for (int y = 0; y < simHeight; y++) {
+        if (projection) {
+            std::fill(row.begin(), row.end(), 0);
+            for (int z = 0; z < depth; z++) {
+                const uint64_t* cells = Row(volume, y, z);
+                for (int w = 0; w < wordsPerRow; w++) row[w] |= cells[w];
+            }
+        }
+        else {
+            const uint64_t* cells = Row(volume, y, viewSlice);
+            std::copy(cells, cells + wordsPerRow, row.begin());
+        }
+
+        for (int w = 0; w < wordsPerRow; w++) {
+            for (uint64_t bits = row[w]; bits != 0; bits &= bits - 1) {
+                Add_Rendered_Point(w * 64 + Lowest_Bit(bits), y);
+            }
+        }
+    }
+}
+
+// fills the volume with random live cells from the given seed, each alive with the given probability
+void Life3D_Randomize(float density, Uint64 seed)
+{
+    SDL_srand(seed);
+    for (int z = 0; z < depth; z++) {
+        for (int y = 0; y < simHeight; y++) {
+            uint64_t* cells = Row(volume, y, z);
+            for (int x = 0; x < simWidth; x++) {
+                if (SDL_randf() < density) cells[x / 64] |= 1ull << (x % 64);
+            }
+        }
+    }
+    Build_View();
+}
+
+// paints a live cell onto the slice being shown
+void Life3D_Paint(int x, int y)
+{
+    Row(volume, y, viewSlice)[x / 64] |= 1ull << (x % 64);
+    Add_Rendered_Point(x, y);
+}
+
+// counts the live cells in the 3x3 column (across y and z) through each cell of word w, as
+// 4 bit planes (the count is at most 9)
+static inline void Column_Count(const uint64_t* const rows[9], int w, uint64_t count[4])
+{
+    uint64_t a0, a1, b0, b1, c0, c1;
+    Full_Add(rows[0][w], rows[1][w], rows[2][w], a0, a1);
+    Full_Add(rows[3][w], rows[4][w], rows[5][w], b0, b1);
+    Full_Add(rows[6][w], rows[7][w], rows[8][w], c0, c1);
+
+    // add up the three 2-bit counts
+    uint64_t carry1, high0, high1;
+    Full_Add(a0, b0, c0, count[0], carry1);
+    Full_Add(a1, b1, c1, high0, high1);
+
+    count[1] = high0 ^ carry1;
+    const uint64_t carry2 = high0 & carry1;
+    count[2] = high1 ^ carry2;
+    count[3] = high1 & carry2;
+}
+
+// the lanes of a 5-plane count that are between low and high, inclusive
+static inline uint64_t In_Range(const uint64_t count[5], int low, int high)
+{
+    uint64_t result = 0;
+    for (int value = low; value <= high; value++) {
+        uint64_t equal = ~0ull;
+        for (int bit = 0; bit < 5; bit++) equal &= (value >> bit & 1) ? count[bit] : ~count[bit];
+        result |= equal;
+    }
+    return result;
+}
+
+// steps slice `task`
+static void Step_Slice(int task, int worker, void* context)
+{
+    const int z = task;
+    int live = 0;
+
+    for (int y = 0; y < simHeight; y++) {
+
+        // the 9 rows in the 3x3 (y, z) neighborhood, wrapping around
+        const uint64_t* rows[9];
+        for (int dz = -1, i = 0; dz <= 1; dz++) {
+            for (int dy = -1; dy <= 1; dy++, i++) {
+                rows[i] = Row(volume, (y + dy + simHeight) % simHeight, (z + dz + depth) % depth);
+            }
+        }
+        const uint64_t* center = rows[4];
+        uint64_t* output = Row(nextVolume, y, z);
+
+        // the column counts of the word to the left, this word and the word to the right
+        uint64_t left[4], middle[4], right[4];
+        Column_Count(rows, wordsPerRow - 1, left);
+        Column_Count(rows, 0, middle);
+
+        for (int w = 0; w < wordsPerRow; w++) {
+            Column_Count(rows, (w + 1) % wordsPerRow, right);
+
+            // bit b is cell x, so the column to its west is bit b - 1, carried over from the
+            // word before at bit 0 (and the other way around for the east)
+            uint64_t west[4], east[4];
+            for (int bit = 0; bit < 4; bit++) {
+                west[bit] = (middle[bit] << 1) | (left[bit] >> 63);
+                east[bit] = (middle[bit] >> 1) | (right[bit] << 63);
+            }
+
+            // add the three column counts into the 3x3x3 count, which includes the cell itself
+            uint64_t count[5], carry1, carryA2, carryB2, carryA3, carryB3, carryA4, carryB4, partial;
+            Full_Add(west[0], middle[0], east[0], count[0], carry1);
+
+            Full_Add(west[1], middle[1], east[1], partial, carryA2);
+            count[1] = partial ^ carry1;
+            carryB2 = partial & carry1;
+
+            Full_Add(west[2], middle[2], east[2], partial, carryA3);
+            Full_Add(partial, carryA2, carryB2, count[2], carryB3);
+
+            Full_Add(west[3], middle[3], east[3], partial, carryA4);
+            Full_Add(partial, carryA3, carryB3, count[3], carryB4);
+
+            count[4] = carryA4 ^ carryB4; // the count is at most 27, so this never carries
+
+            // the count includes a live cell itself, so survival is one higher
+            const uint64_t self = center[w];
+            const uint64_t alive = (self & In_Range(count, surviveLow + 1, surviveHigh + 1))
+                | (~self & In_Range(count, birthLow, birthHigh));
+
+            output[w] = alive;
+            live += Count_Bits(alive);
+
+            for (int bit = 0; bit < 4; bit++) {
+                left[bit] = middle[bit];
+                middle[bit] = right[bit];
+            }
+        }
+    }
+
+    slicePopulations[z] = live;
+}
+
+// steps the whole volume a generation, and rebuilds the view
+void Life3D_Update_Simulation()
+{
+    Scheduler_Run(depth, Step_Slice, NULL);
+    std::swap(volume, nextVolume);
+    Build_View();
+}
+
+// the number of live cells in the whole volume
+int Life3D_Population()
+{
+    int population = 0;
+    for (int live : slicePopulations) population += live;
+    return population;
+}
+
+// a hash of every slice
+Uint64 Life3D_Hash()
+{
+    return Hash_Bytes(volume, (size_t)wordsPerRow * simHeight * depth * sizeof(uint64_t));
+}
+
+// moves the view up or down through the slices
+void Life3D_Change_Slice(int delta)
+{
+    viewSlice = (viewSlice + delta + depth) % depth;
+    projection = false;
+    SDL_Log("showing slice %d of %d", viewSlice, depth);
+    Build_View();
+}
+
+// switches between showing one slice and all of them
+void Life3D_Toggle_Projection()
+{
+    projection = !projection;
+    Build_View();
+}
@@ -0,0 +1,242 @@
+// block cellular automata on the Margolus neighborhood, e.g. the billiard ball model and Critters
+//
+// the board is split into 2x2 blocks, and every block is replaced according to a table of 16
+// entries. the blocks start at even coordinates on even generations and odd coordinates on odd
+// generations (wrapping around the board), so information moves between blocks.
+//
+// blocks are numbered the same way as Golly's MS,D rules: the top-left cell is worth 8, the
+// top-right 4, the bottom-left 2 and the bottom-right 1. when the table is a permutation of
+// 0 to 15 the rule is reversible, and a step can be undone exactly by running the inverse table
+// over the same blocks.
+//
+// in the linear layout the two columns of a block pair are each a straight run of bytes, so 8
+// blocks at a time are looked up with SSSE3 byte shuffles: pshufb is a 16-entry table lookup in
+// every byte, which is exactly the size of the block table. the blocks that wrap around the
+// bottom of the board, and the other layouts, go one at a time.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CELLS_HAVE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+// gcc and clang only allow SSSE3 in functions marked for it, unless the whole build targets it
+#if defined(CELLS_HAVE_SSSE3) && defined(__GNUC__)
+#define SSSE3_FUNCTION __attribute__((target("ssse3")))
+#else
+#define SSSE3_FUNCTION
+#endif
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include "bits.h"
+#include "cells.h"
+#include "layout.h"
+#include "margolus.h"
+
+constexpr int BLOCK_STATES = 16;
+
+// some well known rules
+struct MargolusRule {
+    const char* name;
+    uint8_t table[BLOCK_STATES];
+};
+
+static const MargolusRule MARGOLUS_RULES[] = {
+    { "bbm", { 0, 8, 4, 3, 2, 5, 9, 7, 1, 6, 10, 11, 12, 13, 14, 15 } },
+    { "critters", { 15, 14, 13, 3, 11, 5, 6, 1, 7, 9, 10, 2, 12, 4, 8, 0 } },
+    { "tron", { 15, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 0 } },
+};
+
+// what each block turns into, and back again for reversible rules
+static uint8_t blockTable[BLOCK_STATES];
+static uint8_t inverseTable[BLOCK_STATES];
+static bool reversible = false;
+
+// 0 if the next step uses the blocks at even coordinates, 1 for the odd ones
+static int phase = 0;
+
+// sets the rule, either by name or as 16 numbers separated by commas or semicolons
+// returns false (after logging why) if it can't be read
+bool Parse_Margolus_Rule(const char* text)
+{
+    bool found = false;
+    for (const MargolusRule& rule : MARGOLUS_RULES) {
+        if (SDL_strcmp(text, rule.name) == 0) {
+            SDL_memcpy(blockTable, rule.table, sizeof(blockTable));
+            found = true;
+        }
+    }
+
+    // otherwise it should be a list like 0,8,4,3,2,5,9,7,1,6,10,11,12,13,14,15
+    if (!found) {
+        const char* next = text;
+        int count = 0;
+
+        while (count < BLOCK_STATES) {
+            char* end;
+            const long value = SDL_strtol(next, &end, 10);
+            if (end == next || value < 0 || value >= BLOCK_STATES) break;
+
+            blockTable[count++] = (uint8_t)value;
+            next = end;
+            if (*next == ',' || *next == ';') next++;
+        }
+
+        if (count != BLOCK_STATES || *next != '\0') {
+            SDL_Log("Couldn't read the block rule %s (it should be bbm, critters, tron or 16 numbers from 0 to 15)", text);
+            return false;
+        }
+    }
+
+    // the rule can be run backwards if no two blocks turn into the same thing
+    bool seen[BLOCK_STATES] = {};
+    reversible = true;
+    for (int block = 0; block < BLOCK_STATES; block++) {
+        if (seen[blockTable[block]]) reversible = false;
+        seen[blockTable[block]] = true;
+        inverseTable[blockTable[block]] = (uint8_t)block;
+    }
+
+    phase = 0;
+    return true;
+}
+
+// whether Margolus_Step_Back can undo steps
+bool Margolus_Is_Reversible()
+{
+    return reversible;
+}
+
+// replaces one block using the table, and adds its live cells to the render buffer
+// returns the number of live cells in it afterwards
+static inline int Apply_Block(const uint8_t* table, bool& topLeft, bool& topRight, bool& bottomLeft, bool& bottomRight,
+    int x0, int x1, int y0, int y1)
+{
+    const int block = table[(topLeft << 3) | (topRight << 2) | (bottomLeft << 1) | bottomRight];
+
+    topLeft = (block & 8) != 0;
+    topRight = (block & 4) != 0;
+    bottomLeft = (block & 2) != 0;
+    bottomRight = (block & 1) != 0;
+
+    if (topLeft) Add_Rendered_Point(x0, y0);
+    if (topRight) Add_Rendered_Point(x1, y0);
+    if (bottomLeft) Add_Rendered_Point(x0, y1);
+    if (bottomRight) Add_Rendered_Point(x1, y1);
+    return topLeft + topRight + bottomLeft + bottomRight;
+}
+
+#ifdef CELLS_HAVE_SSSE3
+// replaces the 8 blocks in cells y to y + 15 of columns x0 (left) and x1 (right), given the table
+// split into its four cells: corners[0] holds the top-left cell of each entry, then top-right,
+// bottom-left and bottom-right. returns the number of live cells in them afterwards
+SSSE3_FUNCTION static int Apply_Blocks_Shuffled(bool* left, bool* right, int x0, int x1, int y, const __m128i* corners)
+{
+    const __m128i leftCells = _mm_loadu_si128((const __m128i*)(left + y));
+    const __m128i rightCells = _mm_loadu_si128((const __m128i*)(right + y));
+
+    // each byte becomes its row of a block (left * 2 + right), and a block's number is its top
+    // row * 4 + its bottom row. that's only right in the even bytes, which hold the top rows, but
+    // the odd bytes still come out from 0 to 15, so every byte is a safe index
+    const __m128i rows = _mm_or_si128(_mm_add_epi8(leftCells, leftCells), rightCells);
+    const __m128i topRows = _mm_add_epi8(rows, rows);
+    const __m128i blocks = _mm_or_si128(_mm_add_epi8(topRows, topRows), _mm_srli_si128(rows, 1));
+
+    // the odd bytes look up their block through the even byte before them
+    const __m128i blocksBelow = _mm_slli_si128(blocks, 1);
+    const __m128i evenBytes = _mm_set1_epi16(0x00FF);
+
+    const __m128i newLeft = _mm_or_si128(_mm_and_si128(evenBytes, _mm_shuffle_epi8(corners[0], blocks)),
+        _mm_andnot_si128(evenBytes, _mm_shuffle_epi8(corners[2], blocksBelow)));
+    const __m128i newRight = _mm_or_si128(_mm_and_si128(evenBytes, _mm_shuffle_epi8(corners[1], blocks)),
+        _mm_andnot_si128(evenBytes, _mm_shuffle_epi8(corners[3], blocksBelow)));
+
+    _mm_storeu_si128((__m128i*)(left + y), newLeft);
+    _mm_storeu_si128((__m128i*)(right + y), newRight);
+
+    // only the live cells need visiting for the render buffer
+    const uint64_t leftMask = (uint64_t)_mm_movemask_epi8(_mm_slli_epi16(newLeft, 7));
+    const uint64_t rightMask = (uint64_t)_mm_movemask_epi8(_mm_slli_epi16(newRight, 7));
+    for (uint64_t bits = leftMask; bits != 0; bits &= bits - 1) Add_Rendered_Point(x0, y + Lowest_Bit(bits));
+    for (uint64_t bits = rightMask; bits != 0; bits &= bits - 1) Add_Rendered_Point(x1, y + Lowest_Bit(bits));
+    return Count_Bits(leftMask) + Count_Bits(rightMask);
+}
+#endif
+
+// Apply_Blocks for the linear layout, where the cells of a block are next to each other in two columns
+static int Apply_Blocks_Linear(bool* grid, const uint8_t* table, int offset)
+{
+    int population = 0;
+
+#ifdef CELLS_HAVE_SSSE3
+    // every cpu with SSE4.1 has SSSE3 too, and SDL can't be asked about SSSE3 on its own
+    static const bool haveShuffles = SDL_HasSSE41();
+
+    alignas(16) uint8_t cornerTables[4][BLOCK_STATES];
+    for (int block = 0; block < BLOCK_STATES; block++) {
+        for (int corner = 0; corner < 4; corner++) cornerTables[corner][block] = (table[block] >> (3 - corner)) & 1;
+    }
+    __m128i corners[4];
+    for (int corner = 0; corner < 4; corner++) corners[corner] = _mm_load_si128((const __m128i*)cornerTables[corner]);
+#endif
+
+    for (int x0 = offset; x0 < simWidth + offset; x0 += 2) {
+        const int x1 = (x0 + 1) % simWidth;
+        bool* left = grid + Linear_Index(x0, 0);
+        bool* right = grid + Linear_Index(x1, 0);
+
+        int y0 = offset;
+#ifdef CELLS_HAVE_SSSE3
+        if (haveShuffles) {
+            for (; y0 + 16 <= simHeight; y0 += 16) population += Apply_Blocks_Shuffled(left, right, x0, x1, y0, corners);
+        }
+#endif
+
+        // the rest, including the block that wraps from the bottom of the board to the top
+        for (; y0 < simHeight + offset; y0 += 2) {
+            const int y1 = (y0 + 1) % simHeight;
+            population += Apply_Block(table, left[y0], right[y0], left[y1], right[y1], x0, x1, y0, y1);
+        }
+    }
+
+    return population;
+}
+
+// replaces every block of the given phase using the table, and rebuilds the render buffer
+// returns the number of live cells afterwards
+static int Apply_Blocks(bool* grid, const uint8_t* table, int offset)
+{
+    int population = 0;
+
+    Clear_Rendered_Points();
+    if (gridLayout == GridLayout::Linear) return Apply_Blocks_Linear(grid, table, offset);
+
+    for (int x0 = offset; x0 < simWidth + offset; x0 += 2) {
+        const int x1 = (x0 + 1) % simWidth;
+
+        for (int y0 = offset; y0 < simHeight + offset; y0 += 2) {
+            const int y1 = (y0 + 1) % simHeight;
+            population += Apply_Block(table, grid[Cell_Index(x0, y0)], grid[Cell_Index(x1, y0)],
+                grid[Cell_Index(x0, y1)], grid[Cell_Index(x1, y1)], x0, x1, y0, y1);
+        }
+    }
+
+    return population;
+}
+
+// steps the board forward a generation, in place
+// returns the number of live cells in the next generation
+int Margolus_Update_Simulation(bool* grid)
+{
+    const int population = Apply_Blocks(grid, blockTable, phase);
+    phase ^= 1;
+    return population;
+}
+
+// undoes the last step of a reversible rule, in place
+// returns the number of live cells in the previous generation
+int Margolus_Step_Back(bool* grid)
+{
+    phase ^= 1;
+    return Apply_Blocks(grid, inverseTable, phase);
+}
@@ -0,0 +1,180 @@
+// prometheus metrics (generations, gens/sec, population, a histogram of step times, memory), written
+// every few seconds in the text exposition format for node-exporter's textfile collector
+//
+// the step only ever bumps a few relaxed atomic counters, so it never waits on anything.
+// a thread of its own reads them every interval and writes the file, going through a temporary file
+// and a rename so the collector never sees half of one.
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "alloc.h"
+#include "metrics.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// the upper bounds of the step time histogram's buckets, in seconds. anything slower goes in +Inf
+static const double bucketBounds[] = { 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0 };
+constexpr int BUCKET_COUNT = sizeof(bucketBounds) / sizeof(bucketBounds[0]);
+
+// what the step updates. the buckets aren't cumulative here, they're added up when written
+static std::atomic<Uint64> generations{ 0 };
+static std::atomic<int> population{ 0 };
+static std::atomic<Uint64> stepTicks{ 0 };
+static std::atomic<Uint64> bucketCounts[BUCKET_COUNT + 1];
+
+static Uint64 bucketTicks[BUCKET_COUNT]; // the bounds in performance counter ticks
+static int boardCells = 0;
+
+static std::string metricsFile;
+static std::string temporaryFile;
+static int interval = 10; // seconds between writes
+
+static std::thread writer;
+static std::mutex stopLock;
+static std::condition_variable stopSignal;
+static bool stopping = false;
+
+// the memory the process has in ram, or 0 where that can't be found out
+static Uint64 Resident_Bytes()
+{
+#ifdef __linux__
+    SDL_IOStream* statm = SDL_IOFromFile("/proc/self/statm", "r");
+    if (statm == NULL) return 0;
+
+    char text[128] = {};
+    SDL_ReadIO(statm, text, sizeof(text) - 1);
+    SDL_CloseIO(statm);
+
+    // the second number is the resident set, in pages
+    const char* resident = SDL_strchr(text, ' ');
+    return resident ? SDL_strtoull(resident + 1, NULL, 10) * (Uint64)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+// writes every metric, given how many generations per second there have been since the last write
+static void Write_Metrics(double generationsPerSecond)
+{
+    SDL_IOStream* file = SDL_IOFromFile(temporaryFile.c_str(), "w");
+    if (file == NULL) {
+        SDL_Log("Couldn't write metrics to %s: %s", temporaryFile.c_str(), SDL_GetError());
+        return;
+    }
+
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+
+    SDL_IOprintf(file, "# HELP cells_generations_total Generations stepped since startup.\n");
+    SDL_IOprintf(file, "# TYPE cells_generations_total counter\n");
+    SDL_IOprintf(file, "cells_generations_total %llu\n", (unsigned long long)generations.load(std::memory_order_relaxed));
+
+    SDL_IOprintf(file, "# HELP cells_generations_per_second Generations stepped per second since the last write.\n");
+    SDL_IOprintf(file, "# TYPE cells_generations_per_second gauge\n");
+    SDL_IOprintf(file, "cells_generations_per_second %.3f\n", generationsPerSecond);
+
+    SDL_IOprintf(file, "# HELP cells_population Live cells after the last step.\n");
+    SDL_IOprintf(file, "# TYPE cells_population gauge\n");
+    SDL_IOprintf(file, "cells_population %d\n", population.load(std::memory_order_relaxed));
+
+    SDL_IOprintf(file, "# HELP cells_board_cells Cells on the board.\n");
+    SDL_IOprintf(file, "# TYPE cells_board_cells gauge\n");
+    SDL_IOprintf(file, "cells_board_cells %d\n", boardCells);
+
+    // prometheus buckets count everything up to their bound, so they're added up as they go
+    SDL_IOprintf(file, "# HELP cells_step_seconds Time taken by each step.\n");
+    SDL_IOprintf(file, "# TYPE cells_step_seconds histogram\n");
+    Uint64 cumulative = 0;
+    for (int b = 0; b < BUCKET_COUNT; b++) {
+        cumulative += bucketCounts[b].load(std::memory_order_relaxed);
+        SDL_IOprintf(file, "cells_step_seconds_bucket{le=\"%g\"} %llu\n", bucketBounds[b], (unsigned long long)cumulative);
+    }
+    cumulative += bucketCounts[BUCKET_COUNT].load(std::memory_order_relaxed);
+    SDL_IOprintf(file, "cells_step_seconds_bucket{le=\"+Inf\"} %llu\n", (unsigned long long)cumulative);
+    SDL_IOprintf(file, "cells_step_seconds_sum %.9f\n", (double)stepTicks.load(std::memory_order_relaxed) / frequency);
+    SDL_IOprintf(file, "cells_step_seconds_count %llu\n", (unsigned long long)cumulative);
+
+    SDL_IOprintf(file, "# HELP cells_buffer_bytes Memory reserved for the grids and other big buffers.\n");
+    SDL_IOprintf(file, "# TYPE cells_buffer_bytes gauge\n");
+    SDL_IOprintf(file, "cells_buffer_bytes %llu\n", (unsigned long long)Reserved_Bytes());
+
+    const Uint64 resident = Resident_Bytes();
+    if (resident != 0) {
+        SDL_IOprintf(file, "# HELP cells_resident_bytes Memory the process has in RAM.\n");
+        SDL_IOprintf(file, "# TYPE cells_resident_bytes gauge\n");
+        SDL_IOprintf(file, "cells_resident_bytes %llu\n", (unsigned long long)resident);
+    }
+
+    SDL_CloseIO(file);
+    if (!SDL_RenamePath(temporaryFile.c_str(), metricsFile.c_str())) {
+        SDL_Log("Couldn't move metrics into %s: %s", metricsFile.c_str(), SDL_GetError());
+    }
+}
+
+// writes the metrics every interval until stopped, and once more on the way out
+static void Writer_Thread()
+{
+    Uint64 lastGenerations = 0;
+    Uint64 lastTime = SDL_GetPerformanceCounter();
+
+    bool last = false;
+    while (!last) {
+        {
+            std::unique_lock<std::mutex> lock(stopLock);
+            last = stopSignal.wait_for(lock, std::chrono::seconds(interval), [] { return stopping; });
+        }
+
+        const Uint64 now = SDL_GetPerformanceCounter();
+        const Uint64 count = generations.load(std::memory_order_relaxed);
+        const double seconds = (double)(now - lastTime) / (double)SDL_GetPerformanceFrequency();
+
+        Write_Metrics(seconds > 0 ? (double)(count - lastGenerations) / seconds : 0.0);
+        lastGenerations = count;
+        lastTime = now;
+    }
+}
+
+// starts writing metrics for a board of the given number of cells to file, every interval seconds
+void Metrics_Start(const char* file, int seconds, int cells)
+{
+    metricsFile = file;
+    temporaryFile = metricsFile + ".tmp";
+    interval = SDL_max(seconds, 1);
+    boardCells = cells;
+
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    for (int b = 0; b < BUCKET_COUNT; b++) bucketTicks[b] = (Uint64)(bucketBounds[b] * frequency);
+
+    writer = std::thread(Writer_Thread);
+}
+
+// counts a step that took the given number of performance counter ticks
+void Metrics_Record_Step(Uint64 ticks, int livePopulation)
+{
+    int bucket = 0;
+    while (bucket < BUCKET_COUNT && ticks > bucketTicks[bucket]) bucket++;
+
+    bucketCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+    stepTicks.fetch_add(ticks, std::memory_order_relaxed);
+    population.store(livePopulation, std::memory_order_relaxed);
+    generations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// writes the final metrics and stops the writer
+void Metrics_Stop()
+{
+    if (!writer.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(stopLock);
+        stopping = true;
+    }
+    stopSignal.notify_all();
+    writer.join();
+}
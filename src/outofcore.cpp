@@ -0,0 +1,490 @@
+// out-of-core stepping, for boards that are bigger than memory
+//
+// the board lives in a binary PBM file (P4: a short text header, then one bit per cell,
+// rows padded to whole bytes, most significant bit first, 1 = alive), which any image tool can
+// read and write. each generation streams through the input file with a rolling window of three
+// rows and writes the next generation to a second file, so memory use only depends on the width
+// of the board, never its height.
+//
+// the input is memory mapped a chunk at a time (never the whole file, so this also works in
+// 32-bit builds), with sequential/willneed hints so the kernel reads ahead in big blocks instead
+// of taking a page fault per page. chunks that have been consumed are unmapped and dropped from
+// the page cache. the output is written with plain sequential writes in large blocks.
+//
+// usage: cells --out-of-core <input.pbm> <output.pbm> [--generations N]
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include "outofcore.h"
+
+// how much of the input file is mapped at once
+constexpr uint64_t CHUNK_BYTES = 64ull << 20;
+
+// how much output is gathered before each write
+constexpr size_t WRITE_BLOCK_BYTES = 4 << 20;
+
+#ifdef _WIN32
+typedef HANDLE FileHandle;
+static const FileHandle INVALID_FILE = INVALID_HANDLE_VALUE;
+#else
+typedef int FileHandle;
+static const FileHandle INVALID_FILE = -1;
+#endif
+
+// an input file, with the chunk that is currently mapped
+struct InputFile {
+    FileHandle file = INVALID_FILE;
+#ifdef _WIN32
+    HANDLE mapping = NULL;
+#endif
+    uint64_t size = 0;
+
+    uint8_t* chunk = nullptr; // start of the mapping
+    uint64_t chunkStart = 0; // file offset of the start of the mapping
+    uint64_t chunkEnd = 0; // file offset of the end of the mapping
+};
+
+// an output file and its pending write block
+struct OutputFile {
+    FileHandle file = INVALID_FILE;
+    std::vector<uint8_t> block;
+    uint64_t written = 0;
+};
+
+// the size and layout of a board stored in a PBM file
+struct PbmHeader {
+    int width = 0;
+    int height = 0;
+    uint64_t dataOffset = 0; // where the first row starts
+    size_t rowBytes = 0;
+};
+
+// reverses the bit order of a byte, since PBM stores the leftmost cell in the top bit
+static uint8_t reversedBits[256];
+
+// mapping offsets have to be a multiple of this
+static uint64_t mappingGranularity = 4096;
+
+//
+// platform file handling
+//
+
+static bool Open_Input(const char* path, InputFile& in) {
+#ifdef _WIN32
+    in.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (in.file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(in.file, &size);
+    in.size = (uint64_t)size.QuadPart;
+
+    in.mapping = CreateFileMappingA(in.file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (in.mapping == NULL) return false;
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    mappingGranularity = info.dwAllocationGranularity;
+#else
+    in.file = open(path, O_RDONLY);
+    if (in.file < 0) return false;
+
+    struct stat st;
+    if (fstat(in.file, &st) != 0) return false;
+    in.size = (uint64_t)st.st_size;
+
+    mappingGranularity = (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+    return true;
+}
+
+// reads bytes from a fixed position, without going through the mapping
+static bool Read_At(InputFile& in, uint64_t offset, void* buffer, size_t length) {
+#ifdef _WIN32
+    OVERLAPPED position = {};
+    position.Offset = (DWORD)offset;
+    position.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD read = 0;
+    return ReadFile(in.file, buffer, (DWORD)length, &read, &position) && read == length;
+#else
+    return pread(in.file, buffer, length, (off_t)offset) == (ssize_t)length;
+#endif
+}
+
+static void Unmap_Chunk(InputFile& in) {
+    if (in.chunk == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(in.chunk);
+#else
+    munmap(in.chunk, (size_t)(in.chunkEnd - in.chunkStart));
+
+#ifdef POSIX_FADV_DONTNEED
+    // the chunk has been consumed, so let the kernel drop it rather than evicting something useful
+    posix_fadvise(in.file, (off_t)in.chunkStart, (off_t)(in.chunkEnd - in.chunkStart), POSIX_FADV_DONTNEED);
+#endif
+#endif
+    in.chunk = nullptr;
+}
+
+// maps the chunk of the input file starting at the given offset
+static bool Map_Chunk(InputFile& in, uint64_t offset) {
+    Unmap_Chunk(in);
+
+    in.chunkStart = offset - offset % mappingGranularity;
+    in.chunkEnd = std::min(in.size, in.chunkStart + CHUNK_BYTES);
+    const size_t length = (size_t)(in.chunkEnd - in.chunkStart);
+
+#ifdef _WIN32
+    in.chunk = (uint8_t*)MapViewOfFile(in.mapping, FILE_MAP_READ, (DWORD)(in.chunkStart >> 32), (DWORD)in.chunkStart, length);
+    if (in.chunk == nullptr) return false;
+
+    // ask for the whole chunk up front rather than faulting it in a page at a time
+    WIN32_MEMORY_RANGE_ENTRY range = { in.chunk, length };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // prefault the whole chunk in one go rather than faulting it in a page at a time
+    flags |= MAP_POPULATE;
+#endif
+    void* chunk = mmap(nullptr, length, PROT_READ, flags, in.file, (off_t)in.chunkStart);
+    if (chunk == MAP_FAILED) return false;
+    in.chunk = (uint8_t*)chunk;
+
+    madvise(in.chunk, length, MADV_SEQUENTIAL);
+
+#ifdef POSIX_FADV_WILLNEED
+    // start reading the next chunk from disk while this one is being stepped
+    if (in.chunkEnd < in.size) {
+        posix_fadvise(in.file, (off_t)in.chunkEnd, (off_t)std::min(CHUNK_BYTES, in.size - in.chunkEnd), POSIX_FADV_WILLNEED);
+    }
+#endif
+#endif
+    return true;
+}
+
+// returns a pointer to the bytes at the given offset, mapping a new chunk if needed
+static const uint8_t* Input_Bytes(InputFile& in, uint64_t offset, size_t length) {
+    if (in.chunk == nullptr || offset < in.chunkStart || offset + length > in.chunkEnd) {
+        if (!Map_Chunk(in, offset)) return nullptr;
+    }
+    return in.chunk + (offset - in.chunkStart);
+}
+
+static void Close_Input(InputFile& in) {
+    Unmap_Chunk(in);
+#ifdef _WIN32
+    if (in.mapping != NULL) CloseHandle(in.mapping);
+    if (in.file != INVALID_HANDLE_VALUE) CloseHandle(in.file);
+#else
+    if (in.file >= 0) close(in.file);
+#endif
+    in = InputFile();
+}
+
+static bool Open_Output(const char* path, OutputFile& out) {
+#ifdef _WIN32
+    out.file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (out.file == INVALID_HANDLE_VALUE) return false;
+#else
+    out.file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out.file < 0) return false;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(out.file, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#endif
+    out.block.reserve(WRITE_BLOCK_BYTES);
+    out.written = 0;
+    return true;
+}
+
+// writes out the pending block
+static bool Flush_Output(OutputFile& out) {
+    const uint8_t* data = out.block.data();
+    size_t remaining = out.block.size();
+
+    while (remaining > 0) {
+#ifdef _WIN32
+        DWORD written = 0;
+        if (!WriteFile(out.file, data, (DWORD)std::min(remaining, (size_t)1 << 30), &written, NULL)) return false;
+#else
+        const ssize_t written = write(out.file, data, remaining);
+        if (written <= 0) return false;
+#endif
+        data += written;
+        remaining -= (size_t)written;
+    }
+
+#if defined(__linux__)
+    // start writeback of this block now, and drop the block before it from the page cache once
+    // it's on disk, so dirty pages never pile up and stall the stepper later
+    sync_file_range(out.file, (off_t)out.written, (off_t)out.block.size(), SYNC_FILE_RANGE_WRITE);
+    if (out.written >= WRITE_BLOCK_BYTES) {
+        const off_t previous = (off_t)(out.written - WRITE_BLOCK_BYTES);
+        sync_file_range(out.file, previous, WRITE_BLOCK_BYTES, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(out.file, previous, WRITE_BLOCK_BYTES, POSIX_FADV_DONTNEED);
+    }
+#endif
+
+    out.written += out.block.size();
+    out.block.clear();
+    return true;
+}
+
+static bool Write_Output(OutputFile& out, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (length > 0) {
+        const size_t count = std::min(length, WRITE_BLOCK_BYTES - out.block.size());
+        out.block.insert(out.block.end(), bytes, bytes + count);
+        bytes += count;
+        length -= count;
+
+        if (out.block.size() == WRITE_BLOCK_BYTES && !Flush_Output(out)) return false;
+    }
+    return true;
+}
+
+static bool Close_Output(OutputFile& out) {
+    bool ok = Flush_Output(out);
+#ifdef _WIN32
+    CloseHandle(out.file);
+#else
+    close(out.file);
+#endif
+    out.file = INVALID_FILE;
+    return ok;
+}
+
+//
+// PBM rows
+//
+
+// reads the "P4 <width> <height>" header, skipping any comments
+static bool Read_Pbm_Header(InputFile& in, PbmHeader& header) {
+    char text[256] = {};
+    const size_t length = (size_t)std::min<uint64_t>(sizeof(text) - 1, in.size);
+    if (!Read_At(in, 0, text, length)) return false;
+    if (length < 2 || text[0] != 'P' || text[1] != '4') return false;
+
+    size_t pos = 2;
+    long long numbers[2];
+    for (int i = 0; i < 2; i++) {
+        // skip whitespace and comments
+        while (pos < length && (SDL_isspace(text[pos]) || text[pos] == '#')) {
+            if (text[pos] == '#') while (pos < length && text[pos] != '\n') pos++;
+            else pos++;
+        }
+        if (pos >= length || !SDL_isdigit(text[pos])) return false;
+
+        numbers[i] = 0;
+        while (pos < length && SDL_isdigit(text[pos])) numbers[i] = numbers[i] * 10 + (text[pos++] - '0');
+    }
+    // exactly one whitespace character separates the header from the data
+    if (pos >= length || !SDL_isspace(text[pos])) return false;
+    pos++;
+
+    if (numbers[0] < 3 || numbers[1] < 3 || numbers[0] > INT32_MAX || numbers[1] > INT32_MAX) return false;
+
+    header.width = (int)numbers[0];
+    header.height = (int)numbers[1];
+    header.dataOffset = pos;
+    header.rowBytes = ((size_t)header.width + 7) / 8;
+
+    return in.size >= header.dataOffset + (uint64_t)header.rowBytes * header.height;
+}
+
+static bool Write_Pbm_Header(OutputFile& out, const PbmHeader& header) {
+    char text[64];
+    const int length = SDL_snprintf(text, sizeof(text), "P4\n%d %d\n", header.width, header.height);
+    return Write_Output(out, text, (size_t)length);
+}
+
+// converts a PBM row into 64-bit words, with cell x in bit (x % 64) of word (x / 64)
+static void Unpack_Row(const uint8_t* bytes, size_t rowBytes, uint64_t* words, size_t wordCount) {
+    std::fill(words, words + wordCount, 0);
+    for (size_t i = 0; i < rowBytes; i++) {
+        words[i / 8] |= (uint64_t)reversedBits[bytes[i]] << (8 * (i % 8));
+    }
+}
+
+// converts 64-bit words back into a PBM row
+static void Pack_Row(const uint64_t* words, uint8_t* bytes, size_t rowBytes) {
+    for (size_t i = 0; i < rowBytes; i++) {
+        bytes[i] = reversedBits[(words[i / 8] >> (8 * (i % 8))) & 0xFF];
+    }
+}
+
+// computes the next generation of one row from the rows above and below it, 64 cells at a time.
+// each cell's neighbor count is built with bitwise adders across whole words, so there is no
+// per-cell work at all. the board wraps around horizontally as well as vertically
+static void Step_Row(const uint64_t* above, const uint64_t* row, const uint64_t* below, uint64_t* next, int width) {
+    const size_t wordCount = ((size_t)width + 63) / 64;
+    const int lastBit = (width - 1) % 64;
+    const uint64_t lastMask = (lastBit == 63) ? ~0ull : ((1ull << (lastBit + 1)) - 1);
+
+    for (size_t i = 0; i < wordCount; i++) {
+        const uint64_t* rows[3] = { above, row, below };
+        uint64_t west[3], center[3], east[3];
+
+        for (int r = 0; r < 3; r++) {
+            const uint64_t* words = rows[r];
+
+            // the neighbor to the west of cell x is cell x - 1, so shift left, pulling in the top
+            // bit of the previous word (or the last cell of the row, wrapping around)
+            const uint64_t westIn = (i == 0) ? (words[wordCount - 1] >> lastBit) & 1 : words[i - 1] >> 63;
+            const uint64_t eastIn = (i == wordCount - 1) ? (words[0] & 1) << lastBit : words[i + 1] << 63;
+
+            center[r] = words[i];
+            west[r] = (words[i] << 1) | westIn;
+            east[r] = (i == wordCount - 1) ? ((words[i] >> 1) & ~(1ull << lastBit)) | eastIn : (words[i] >> 1) | eastIn;
+        }
+
+        // add up each of the three rows of the neighborhood (leaving out the cell itself)
+        const uint64_t topOnes = west[0] ^ center[0] ^ east[0];
+        const uint64_t topTwos = (west[0] & center[0]) | (east[0] & (west[0] ^ center[0]));
+        const uint64_t midOnes = west[1] ^ east[1];
+        const uint64_t midTwos = west[1] & east[1];
+        const uint64_t bottomOnes = west[2] ^ center[2] ^ east[2];
+        const uint64_t bottomTwos = (west[2] & center[2]) | (east[2] & (west[2] ^ center[2]));
+
+        // then add the three rows together. the count is ones + 2 * (number of twos set), and a
+        // cell can only be alive next step if exactly one of the four twos is set (a count of 2 or 3)
+        const uint64_t ones = topOnes ^ midOnes ^ bottomOnes;
+        const uint64_t onesCarry = (topOnes & midOnes) | (bottomOnes & (topOnes ^ midOnes));
+
+        const uint64_t twosA = topTwos ^ midTwos;
+        const uint64_t twosB = bottomTwos ^ onesCarry;
+        const uint64_t exactlyOneTwo = (twosA ^ twosB) & ~((topTwos & midTwos) | (bottomTwos & onesCarry));
+
+        // born with 3 neighbors, survives with 2 or 3
+        next[i] = exactlyOneTwo & (ones | center[1]);
+    }
+
+    next[wordCount - 1] &= lastMask;
+}
+
+// steps one generation from one file into another
+static bool Step_File(const char* inputPath, const char* outputPath, uint64_t& bytesMoved) {
+    InputFile in;
+    OutputFile out;
+    PbmHeader header;
+
+    if (!Open_Input(inputPath, in)) {
+        SDL_Log("Couldn't open %s", inputPath);
+        Close_Input(in);
+        return false;
+    }
+    if (!Read_Pbm_Header(in, header)) {
+        SDL_Log("%s isn't a binary (P4) PBM file of at least 3x3 cells", inputPath);
+        Close_Input(in);
+        return false;
+    }
+    if (!Open_Output(outputPath, out)) {
+        SDL_Log("Couldn't create %s", outputPath);
+        Close_Input(in);
+        return false;
+    }
+
+    const size_t wordCount = ((size_t)header.width + 63) / 64;
+    const size_t rowBytes = header.rowBytes;
+
+    // the rolling window, plus copies of the first and last rows since the board wraps vertically
+    std::vector<uint64_t> window[3], firstRow(wordCount), lastRow(wordCount), next(wordCount);
+    for (auto& row : window) row.resize(wordCount);
+    std::vector<uint8_t> bytes(rowBytes);
+
+    bool ok = Write_Pbm_Header(out, header);
+
+    const uint64_t lastRowOffset = header.dataOffset + (uint64_t)rowBytes * (header.height - 1);
+    ok = ok && Read_At(in, header.dataOffset, bytes.data(), rowBytes);
+    Unpack_Row(bytes.data(), rowBytes, firstRow.data(), wordCount);
+    ok = ok && Read_At(in, lastRowOffset, bytes.data(), rowBytes);
+    Unpack_Row(bytes.data(), rowBytes, lastRow.data(), wordCount);
+
+    uint64_t* above = window[0].data();
+    uint64_t* row = window[1].data();
+    uint64_t* below = window[2].data();
+    std::copy(lastRow.begin(), lastRow.end(), above);
+    std::copy(firstRow.begin(), firstRow.end(), row);
+
+    for (int y = 0; ok && y < header.height; y++) {
+
+        // bring the row below into the window
+        if (y + 1 < header.height) {
+            const uint8_t* source = Input_Bytes(in, header.dataOffset + (uint64_t)rowBytes * (y + 1), rowBytes);
+            if (source == nullptr) {
+                SDL_Log("Couldn't map %s", inputPath);
+                ok = false;
+                break;
+            }
+            Unpack_Row(source, rowBytes, below, wordCount);
+        }
+        else std::copy(firstRow.begin(), firstRow.end(), below);
+
+        Step_Row(above, row, below, next.data(), header.width);
+
+        Pack_Row(next.data(), bytes.data(), rowBytes);
+        ok = Write_Output(out, bytes.data(), rowBytes);
+
+        // slide the window down a row
+        std::swap(above, row);
+        std::swap(row, below);
+    }
+
+    ok = Close_Output(out) && ok;
+    Close_Input(in);
+
+    if (!ok) SDL_Log("Couldn't step %s into %s", inputPath, outputPath);
+    bytesMoved += (uint64_t)rowBytes * header.height * 2;
+    return ok;
+}
+
+// steps the board in inputPath for the given number of generations, leaving the result in
+// outputPath. with more than one generation, the intermediate boards ping-pong between
+// outputPath and a temporary file next to it
+bool Out_Of_Core_Run(const char* inputPath, const char* outputPath, int generations) {
+    if (SDL_strcmp(inputPath, outputPath) == 0) {
+        SDL_Log("The out-of-core input and output must be different files");
+        return false;
+    }
+    if (generations < 1) generations = 1;
+
+    for (int i = 0; i < 256; i++) {
+        uint8_t reversed = 0;
+        for (int bit = 0; bit < 8; bit++) if (i & (1 << bit)) reversed |= (uint8_t)(0x80 >> bit);
+        reversedBits[i] = reversed;
+    }
+
+    const std::string tempPath = std::string(outputPath) + ".tmp";
+    const Uint64 start = SDL_GetPerformanceCounter();
+    uint64_t bytesMoved = 0;
+
+    const char* source = inputPath;
+    for (int generation = 0; generation < generations; generation++) {
+
+        // the last generation always lands in outputPath
+        const char* destination = ((generations - 1 - generation) % 2 == 0) ? outputPath : tempPath.c_str();
+
+        if (!Step_File(source, destination, bytesMoved)) return false;
+        source = destination;
+    }
+    if (generations > 1) SDL_RemovePath(tempPath.c_str());
+
+    const double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    SDL_Log("stepped %d generation(s) in %.2f s (%.1f MB/s read + written)",
+        generations, seconds, (double)bytesMoved / (1 << 20) / seconds);
+
+    return true;
+}
@@ -0,0 +1,177 @@
+// the parallel dense engine: the same rules as Update_Simulation_Dense, for the linear layout,
+// run on all the scheduler's workers
+//
+// the board is cut into tiles of TILE_COLUMNS x TILE_ROWS cells, and every tile is a task. a tile
+// is only recomputed if it or one of its 8 neighbors changed last step (or was painted), so a
+// board that has mostly settled leaves most tiles with nothing to do. the workers whose block of
+// tiles was quiet then steal from the ones whose tiles are busy.
+//
+// each tile keeps a list of its live cells, so quiet tiles don't need visiting to be drawn. once
+// every tile is stepped, a second pass of tasks copies the lists into the render buffer, which
+// also counts the population.
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include <cstdint>
+#include "cells.h"
+#include "layout.h"
+#include "scheduler.h"
+#include "parallel.h"
+#include "trace.h"
+
+// the size of a tile. tiles are tall and thin so each task reads long runs of each column
+constexpr int TILE_COLUMNS = 32;
+constexpr int TILE_ROWS = 256;
+
+struct ParallelTile {
+    std::vector<SDL_FPoint> points; // the live cells of the tile, as of the last time it was stepped
+    int renderOffset = 0; // where the points go in the render buffer
+};
+
+static std::vector<ParallelTile> tiles;
+static int tilesX = 0;
+static int tilesY = 0;
+
+// whether each tile changed last step, and whether it changes this step
+static std::vector<uint8_t> changedLast;
+static std::vector<uint8_t> changedNow;
+
+// set when the grid was changed behind this engine's back, so every tile gets stepped
+static bool stepEverything = true;
+
+// the grids for the step being run
+struct ParallelPass {
+    const bool* current;
+    bool* next;
+    SDL_FPoint* renderPoints;
+};
+
+// tiles are numbered down each column of tiles first, so neighboring task numbers share columns
+static inline int Tile_Number(int tx, int ty) {
+    return tx * tilesY + ty;
+}
+
+// sizes the tile lists for the board
+void Parallel_Setup()
+{
+    tilesX = (simWidth + TILE_COLUMNS - 1) / TILE_COLUMNS;
+    tilesY = (simHeight + TILE_ROWS - 1) / TILE_ROWS;
+
+    tiles.assign((size_t)tilesX * tilesY, ParallelTile());
+    changedLast.assign(tiles.size(), 0);
+    changedNow.assign(tiles.size(), 0);
+    stepEverything = true;
+}
+
+// makes the next step recompute every tile, e.g. after another engine has been stepping the grid
+void Parallel_Invalidate()
+{
+    stepEverything = true;
+}
+
+// marks the tile holding the given cell as changed, so it and its neighbors get stepped next time
+void Parallel_Mark_Changed(int x, int y)
+{
+    if (tiles.empty()) return;
+    changedLast[Tile_Number(x / TILE_COLUMNS, y / TILE_ROWS)] = 1;
+}
+
+// whether the tile or any of its neighbors (wrapping around the board) changed last step
+static bool Tile_Needs_Step(int tx, int ty)
+{
+    for (int dx = -1; dx <= 1; dx++) {
+        const int nx = (tx + dx + tilesX) % tilesX;
+        for (int dy = -1; dy <= 1; dy++) {
+            const int ny = (ty + dy + tilesY) % tilesY;
+            if (changedLast[Tile_Number(nx, ny)]) return true;
+        }
+    }
+    return false;
+}
+
+// steps one tile
+static void Step_Tile(int task, int worker, void* context)
+{
+    const ParallelPass& pass = *(const ParallelPass*)context;
+    const int tx = task / tilesY;
+    const int ty = task % tilesY;
+
+    const int x0 = tx * TILE_COLUMNS;
+    const int x1 = SDL_min(x0 + TILE_COLUMNS, simWidth);
+    const int y0 = ty * TILE_ROWS;
+    const int y1 = SDL_min(y0 + TILE_ROWS, simHeight);
+
+    if (!stepEverything && !Tile_Needs_Step(tx, ty)) {
+        // nothing nearby changed, so neither does this tile. the next grid still needs the
+        // tile copied into it, since the two grids get swapped
+        for (int x = x0; x < x1; x++) {
+            SDL_memcpy(pass.next + Linear_Index(x, y0), pass.current + Linear_Index(x, y0), (size_t)(y1 - y0));
+        }
+        changedNow[task] = 0;
+        return;
+    }
+
+    std::vector<SDL_FPoint>& points = tiles[task].points;
+    points.clear();
+    bool changed = false;
+
+    for (int x = x0; x < x1; x++) {
+
+        // the three columns of the neighborhood, wrapping around horizontally
+        const bool* left = pass.current + Linear_Index(x == 0 ? simWidth - 1 : x - 1, 0);
+        const bool* column = pass.current + Linear_Index(x, 0);
+        const bool* right = pass.current + Linear_Index(x == simWidth - 1 ? 0 : x + 1, 0);
+        bool* output = pass.next + Linear_Index(x, 0);
+
+        for (int y = y0; y < y1; y++) {
+            const int up = (y == 0) ? simHeight - 1 : y - 1;
+            const int down = (y == simHeight - 1) ? 0 : y + 1;
+
+            const int neighbors = left[up] + left[y] + left[down]
+                + column[up] + column[down]
+                + right[up] + right[y] + right[down];
+
+            const bool alive = neighbors == 3 || (neighbors == 2 && column[y]);
+            output[y] = alive;
+            changed |= alive != column[y];
+
+            if (alive) points.push_back({ (float)x, (float)y });
+        }
+    }
+
+    changedNow[task] = changed;
+}
+
+// copies one tile's live cells into the render buffer
+static void Gather_Tile(int task, int worker, void* context)
+{
+    const ParallelPass& pass = *(const ParallelPass*)context;
+    const ParallelTile& tile = tiles[task];
+
+    if (!tile.points.empty()) {
+        SDL_memcpy(pass.renderPoints + tile.renderOffset, tile.points.data(), tile.points.size() * sizeof(SDL_FPoint));
+    }
+}
+
+// steps the whole board from current into next, and fills the render buffer with the live cells
+// returns the number of live cells in the next generation
+int Parallel_Update_Simulation(const bool* current, bool* next, SDL_FPoint* renderPoints)
+{
+    ParallelPass pass = { current, next, renderPoints };
+    const int tileCount = (int)tiles.size();
+
+    Scheduler_Run(tileCount, Step_Tile, &pass);
+    stepEverything = false;
+    changedLast.swap(changedNow);
+
+    // each tile's points go right after the ones before it
+    int population = 0;
+    for (ParallelTile& tile : tiles) {
+        tile.renderOffset = population;
+        population += (int)tile.points.size();
+    }
+
+    TraceSpan span("gather render points");
+    Scheduler_Run(tileCount, Gather_Tile, &pass);
+    return population;
+}
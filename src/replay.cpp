@@ -0,0 +1,307 @@
+// records the input events of a windowed session to a file, and replays them headless, so slowdowns
+// that only show up while painting at speed can be profiled and turned into regression tests
+//
+// the window only steps when enough wall clock time has passed, so the recording doesn't just hold
+// the events: it numbers the frames, and writes down which frames stepped and what modifier keys
+// were held while painting. replaying feeds each frame's events back through SDL_AppEvent, paints,
+// and steps exactly where the recording did, as fast as it can. starting from the same seed, that
+// ends on the same board, which the last line of the recording holds a hash of. the options the
+// session was started with are kept too (one per line, so nothing needs quoting), and replays start
+// with them, so the engine, rule, layout and so on don't have to be typed in again.
+//
+// the file is text, one record per line:
+//   cells-record 1
+//   seed <seed>
+//   size <width>x<height>
+//   scale <render scale>
+//   arg <option>                          (for each command line argument but --record's)
+//   e <frame> <ms> wheel <y>              (and keydown <key>, buttondown/buttonup <button> <x> <y>, motion <x> <y>)
+//   m <frame> <modifier keys>             (when they change while painting)
+//   s <frame>                             (the frame stepped)
+//   end <frames> <hash> <population>
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+#include "cells.h"
+#include "replay.h"
+
+constexpr int RECORD_VERSION = 1;
+
+enum class RecordKind {
+    Event,
+    ModState,
+    Step
+};
+
+struct Record {
+    RecordKind kind;
+    int frame;
+    SDL_Event event; // for events
+    SDL_Keymod mod; // for modifier states
+};
+
+// recording
+static SDL_IOStream* recording = NULL;
+static Uint64 recordStartNS = 0;
+static int recordFrame = 0;
+static SDL_Keymod recordedMod = 0;
+
+// replaying
+static std::vector<Record> records;
+static std::vector<std::string> recordedArguments;
+static std::vector<char*> recordedArgv;
+static size_t nextRecord = 0;
+static int replayFrame = 0;
+static int replayFrames = 0;
+static SDL_Keymod replayMod = 0;
+static bool haveExpected = false;
+static Uint64 expectedHash = 0;
+static int expectedPopulation = 0;
+
+// starts writing the events of this session, started with the given command line, to file
+bool Record_Start(const char* file, Uint64 seed, int scale, int argc, char* argv[])
+{
+    recording = SDL_IOFromFile(file, "w");
+    if (recording == NULL) {
+        SDL_Log("Couldn't record to %s: %s", file, SDL_GetError());
+        return false;
+    }
+
+    recordStartNS = SDL_GetTicksNS();
+    SDL_IOprintf(recording, "cells-record %d\n", RECORD_VERSION);
+    SDL_IOprintf(recording, "seed %llu\n", (unsigned long long)seed);
+    SDL_IOprintf(recording, "size %dx%d\n", simWidth, simHeight);
+    SDL_IOprintf(recording, "scale %d\n", scale);
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp(argv[i], "--record") == 0 && i + 1 < argc) i++;
+        else SDL_IOprintf(recording, "arg %s\n", argv[i]);
+    }
+    return true;
+}
+
+// writes down an event, if it's one SDL_AppEvent does anything with
+void Record_Event(const SDL_Event* event)
+{
+    if (recording == NULL) return;
+
+    const double ms = (double)(event->common.timestamp - recordStartNS) / 1e6;
+    switch (event->type) {
+    case SDL_EVENT_MOUSE_WHEEL:
+        SDL_IOprintf(recording, "e %d %.3f wheel %g\n", recordFrame, ms, event->wheel.y);
+        break;
+    case SDL_EVENT_KEY_DOWN:
+        SDL_IOprintf(recording, "e %d %.3f keydown %u\n", recordFrame, ms, (unsigned)event->key.key);
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        SDL_IOprintf(recording, "e %d %.3f %s %d %.9g %.9g\n", recordFrame, ms, event->type == SDL_EVENT_MOUSE_BUTTON_DOWN ? "buttondown" : "buttonup",
+            (int)event->button.button, event->button.x, event->button.y);
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        SDL_IOprintf(recording, "e %d %.3f motion %.9g %.9g\n", recordFrame, ms, event->motion.x, event->motion.y);
+        break;
+    default:
+        break;
+    }
+}
+
+// writes down the modifier keys held while painting, if they've changed
+void Record_Mod_State(SDL_Keymod mod)
+{
+    if (recording == NULL || mod == recordedMod) return;
+    SDL_IOprintf(recording, "m %d %u\n", recordFrame, (unsigned)mod);
+    recordedMod = mod;
+}
+
+// writes down that this frame stepped the simulation
+void Record_Step()
+{
+    if (recording == NULL) return;
+    SDL_IOprintf(recording, "s %d\n", recordFrame);
+}
+
+void Record_End_Frame()
+{
+    if (recording != NULL) recordFrame++;
+}
+
+// finishes the recording with where the board ended up
+void Record_Stop(Uint64 hash, int population)
+{
+    if (recording == NULL) return;
+
+    SDL_IOprintf(recording, "end %d %llu %d\n", recordFrame, (unsigned long long)hash, population);
+    SDL_CloseIO(recording);
+    recording = NULL;
+    SDL_Log("recorded %d frames", recordFrame);
+}
+
+// reads one line of a recording into records
+// returns false if it doesn't make sense
+static bool Parse_Record(const char* line)
+{
+    Record record = {};
+    char name[16] = {};
+    double ms = 0;
+    unsigned value = 0;
+    int button = 0;
+    float x = 0, y = 0;
+
+    if (SDL_sscanf(line, "e %d %lf %15s", &record.frame, &ms, name) == 3) {
+        const char* rest = SDL_strstr(line, name) + SDL_strlen(name);
+        record.kind = RecordKind::Event;
+
+        if (SDL_strcmp(name, "wheel") == 0 && SDL_sscanf(rest, "%f", &y) == 1) {
+            record.event.type = SDL_EVENT_MOUSE_WHEEL;
+            record.event.wheel.y = y;
+        }
+        else if (SDL_strcmp(name, "keydown") == 0 && SDL_sscanf(rest, "%u", &value) == 1) {
+            record.event.type = SDL_EVENT_KEY_DOWN;
+            record.event.key.key = (SDL_Keycode)value;
+        }
+        else if ((SDL_strcmp(name, "buttondown") == 0 || SDL_strcmp(name, "buttonup") == 0) && SDL_sscanf(rest, "%d %f %f", &button, &x, &y) == 3) {
+            record.event.type = SDL_strcmp(name, "buttondown") == 0 ? SDL_EVENT_MOUSE_BUTTON_DOWN : SDL_EVENT_MOUSE_BUTTON_UP;
+            record.event.button.button = (Uint8)button;
+            record.event.button.x = x;
+            record.event.button.y = y;
+        }
+        else if (SDL_strcmp(name, "motion") == 0 && SDL_sscanf(rest, "%f %f", &x, &y) == 2) {
+            record.event.type = SDL_EVENT_MOUSE_MOTION;
+            record.event.motion.x = x;
+            record.event.motion.y = y;
+        }
+        else return false;
+    }
+    else if (SDL_sscanf(line, "m %d %u", &record.frame, &value) == 2) {
+        record.kind = RecordKind::ModState;
+        record.mod = (SDL_Keymod)value;
+    }
+    else if (SDL_sscanf(line, "s %d", &record.frame) == 1) {
+        record.kind = RecordKind::Step;
+    }
+    else {
+        unsigned long long hash = 0;
+        if (SDL_sscanf(line, "end %d %llu %d", &replayFrames, &hash, &expectedPopulation) == 3) {
+            expectedHash = hash;
+            haveExpected = true;
+        }
+        return SDL_strncmp(line, "end ", 4) == 0 || SDL_strncmp(line, "cells-record ", 13) == 0
+            || SDL_strncmp(line, "seed ", 5) == 0 || SDL_strncmp(line, "size ", 5) == 0 || SDL_strncmp(line, "scale ", 6) == 0;
+    }
+
+    records.push_back(record);
+    replayFrames = SDL_max(replayFrames, record.frame + 1);
+    return true;
+}
+
+// reads a recording, and the seed, board size and render scale it was made with
+// returns false (after logging why) if it can't be replayed
+bool Replay_Load(const char* file, Uint64* seed, int* width, int* height, int* scale)
+{
+    size_t size = 0;
+    char* text = (char*)SDL_LoadFile(file, &size);
+    if (text == NULL) {
+        SDL_Log("Couldn't read the recording %s: %s", file, SDL_GetError());
+        return false;
+    }
+
+    int version = 0;
+    bool ok = SDL_sscanf(text, "cells-record %d", &version) == 1 && version == RECORD_VERSION;
+
+    int lineNumber = 0;
+    for (char* line = text; ok && line < text + size; ) {
+        char* end = SDL_strchr(line, '\n');
+        if (end != NULL) *end = '\0';
+        lineNumber++;
+
+        unsigned long long recordedSeed = 0;
+        if (SDL_sscanf(line, "seed %llu", &recordedSeed) == 1) *seed = recordedSeed;
+        else if (SDL_sscanf(line, "size %dx%d", width, height) == 2) {}
+        else if (SDL_sscanf(line, "scale %d", scale) == 1) {}
+        else if (SDL_strncmp(line, "arg ", 4) == 0) recordedArguments.push_back(line + 4);
+        else if (line[0] != '\0' && !Parse_Record(line)) {
+            SDL_Log("Line %d of the recording %s doesn't make sense: %s", lineNumber, file, line);
+            ok = false;
+        }
+
+        if (end == NULL) break;
+        line = end + 1;
+    }
+
+    if (version != RECORD_VERSION) SDL_Log("%s isn't a recording this version can replay", file);
+    SDL_free(text);
+
+    std::string options;
+    for (const std::string& argument : recordedArguments) options += " " + argument;
+    if (ok) SDL_Log("replaying with the recorded options:%s", options.empty() ? " (none)" : options.c_str());
+    return ok;
+}
+
+// the command line the recording was started with, laid out like main's (so argv[0] is a placeholder)
+// for Parse_Arguments
+char** Replay_Arguments(int* argc)
+{
+    static char program[] = "cells";
+    recordedArgv.assign(1, program);
+    for (std::string& argument : recordedArguments) recordedArgv.push_back(&argument[0]);
+    recordedArgv.push_back(NULL);
+
+    *argc = (int)recordedArgv.size() - 1;
+    return recordedArgv.data();
+}
+
+// the next event of the current frame
+// returns false once there are no more
+bool Replay_Next_Event(SDL_Event* event)
+{
+    if (nextRecord >= records.size()) return false;
+
+    const Record& record = records[nextRecord];
+    if (record.frame != replayFrame || record.kind != RecordKind::Event) return false;
+
+    *event = record.event;
+    nextRecord++;
+    return true;
+}
+
+// the modifier keys that were held while painting this frame
+SDL_Keymod Replay_Mod_State()
+{
+    while (nextRecord < records.size() && records[nextRecord].frame == replayFrame && records[nextRecord].kind == RecordKind::ModState) {
+        replayMod = records[nextRecord].mod;
+        nextRecord++;
+    }
+    return replayMod;
+}
+
+// whether this frame stepped
+bool Replay_Step()
+{
+    // anything this frame didn't get round to (like modifier keys while not painting) is skipped
+    while (nextRecord < records.size() && records[nextRecord].frame == replayFrame && records[nextRecord].kind != RecordKind::Step) {
+        nextRecord++;
+    }
+
+    if (nextRecord < records.size() && records[nextRecord].frame == replayFrame) {
+        nextRecord++;
+        return true;
+    }
+    return false;
+}
+
+// moves on to the next frame
+// returns false once the recording is over
+bool Replay_End_Frame()
+{
+    replayFrame++;
+    return replayFrame < replayFrames;
+}
+
+// the hash and population the recording ended with, if it got as far as writing them
+bool Replay_Expected(Uint64* hash, int* population)
+{
+    *hash = expectedHash;
+    *population = expectedPopulation;
+    return haveExpected;
+}
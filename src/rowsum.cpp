@@ -0,0 +1,94 @@
+// the row-sum kernel: the same rules as Update_Simulation_Dense, for the linear and row-major
+// layouts, with the 3x3 neighborhood counted as two passes of 3-cell sums instead of 8 separate
+// lookups
+//
+// the board is walked as lines of cells that are next to each other in memory: columns in the
+// linear layout and rows in the row-major one. life is the same turned on its side, so nothing
+// else changes. each line is first summed along its length (every cell plus the ones either side
+// of it) into a scratch line, then three neighboring scratch lines are added to get the whole 3x3
+// block. the block includes the cell itself, so a cell is alive next generation if the block
+// holds 3 (born with 3 neighbors, or surviving with 2) or holds 4 and the cell is alive
+// (surviving with 3).
+//
+// every sum is used by three lines, so each cell costs two adds for its own line's sum and two to
+// combine the lines, with no branches or wrap checks outside the first and last cell of each line.
+// the loops are all straight runs over bytes, which compilers vectorize.
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include "bits.h"
+#include "cells.h"
+#include "layout.h"
+#include "rowsum.h"
+
+// the sums of the lines either side of the one being stepped, and of line 0, which the last
+// line needs again after it's been scrolled out
+static std::vector<uint8_t> sumLines;
+
+// sums each cell of a line with the ones either side of it, wrapping around at the ends
+static void Sum_Line(const uint8_t* line, uint8_t* sums, int length)
+{
+    const int last = length - 1;
+
+    sums[0] = line[last] + line[0] + line[1];
+    for (int i = 1; i < last; i++) sums[i] = line[i - 1] + line[i] + line[i + 1];
+    sums[last] = line[last - 1] + line[last] + line[0];
+}
+
+// steps the whole board from current into next
+// returns the number of live cells in the next generation
+int Update_Simulation_Row_Sum(const bool* current, bool* next)
+{
+    // columns of simHeight cells, or rows of simWidth cells gridStride apart
+    const bool rowMajor = gridLayout == GridLayout::RowMajor;
+    const int lineCount = rowMajor ? simHeight : simWidth;
+    const int lineLength = rowMajor ? simWidth : simHeight;
+    const size_t lineStride = rowMajor ? (size_t)gridStride : (size_t)simHeight;
+
+    const size_t length = (size_t)lineLength;
+    if (sumLines.size() != length * 4) sumLines.assign(length * 4, 0);
+
+    uint8_t* left = sumLines.data();
+    uint8_t* middle = left + length;
+    uint8_t* right = middle + length;
+    uint8_t* first = right + length;
+
+    // bools are bytes holding 0 or 1, so they can be added up directly
+    const uint8_t* cells = (const uint8_t*)current;
+    uint8_t* output = (uint8_t*)next;
+
+    Sum_Line(cells + (lineCount - 1) * lineStride, left, lineLength);
+    Sum_Line(cells, first, lineLength);
+    SDL_memcpy(middle, first, length);
+
+    int population = 0;
+    Clear_Rendered_Points();
+
+    for (int l = 0; l < lineCount; l++) {
+        if (l == lineCount - 1) SDL_memcpy(right, first, length);
+        else Sum_Line(cells + (l + 1) * lineStride, right, lineLength);
+
+        const uint8_t* line = cells + l * lineStride;
+        uint8_t* out = output + l * lineStride;
+
+        for (int i = 0; i < lineLength; i++) {
+            const uint8_t block = left[i] + middle[i] + right[i];
+            out[i] = (uint8_t)((block == 3) | ((block == 4) & line[i]));
+        }
+
+        For_Each_Live_Byte(out, lineLength, [&](int at) {
+            if (rowMajor) Add_Rendered_Point(at, l);
+            else Add_Rendered_Point(l, at);
+            population++;
+        });
+
+        // scroll the lines across for the next one
+        uint8_t* oldLeft = left;
+        left = middle;
+        middle = right;
+        right = oldLeft;
+    }
+
+    return population;
+}
@@ -0,0 +1,463 @@
+// rules other than B3/S23, given either in Hensel notation (e.g. B2n3/S23-q) or as a MAP string,
+// and stochastic rules where births and survivals only happen with some probability
+//
+// both compile to the same thing: a table with an entry for each of the 512 ways the 3x3
+// neighborhood of a cell can look, saying whether the cell is alive next generation. the index
+// has one bit per cell, from NW (the top bit) through N, NE, W, the cell itself, E, SW and S to SE
+// (the bottom bit), which is the order MAP strings are written in.
+//
+// stepping down a column, the neighborhood of the next cell is the old one shifted up a row with
+// the new bottom row added, so each cell costs three loads and a table lookup. Rule_Compile
+// turns the table into native code instead (see jit.cpp), which steps 16 cells at a time.
+//
+// for stochastic rules, every 64 cells of a column get a mask of which of them may be born and a
+// mask of which may survive, made 64 coin flips at a time from a counter-based generator. the
+// counter is the position of the 64 cells and the key comes from the seed and the generation,
+// so a run is the same for a given seed however the columns get shared out between threads.
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "bits.h"
+#include "cells.h"
+#include "layout.h"
+#include "rules.h"
+#include "scheduler.h"
+#include "jit.h"
+#include "trace.h"
+
+constexpr int NEIGHBORHOODS = 512;
+
+// the bit of the neighborhood index for the cell itself
+constexpr int CENTER_BIT = 1 << 4;
+
+// whether the cell with each neighborhood is alive next generation
+static uint8_t ruleTable[NEIGHBORHOODS];
+
+// whether the table is plain Conway's life, which all the other engines assume
+static bool ruleIsLife = true;
+
+// whether a rule has been given, rather than the table just being left empty
+static bool ruleParsed = false;
+
+// the rule as it was written, which compiled kernels are cached under
+static std::string ruleName = "B3/S23";
+
+// the table compiled to native code by Rule_Compile, if it has been
+static JitKernel compiledKernel = NULL;
+
+// probabilities are kept as fractions of 2^16
+constexpr int PROBABILITY_BITS = 16;
+constexpr int PROBABILITY_ONE = 1 << PROBABILITY_BITS;
+
+// the chance that a cell the rule says is born (or survives) actually is
+static int birthThreshold = PROBABILITY_ONE;
+static int survivalThreshold = PROBABILITY_ONE;
+static bool stochastic = false;
+
+// the random numbers for each generation are keyed on the seed and the generation number
+static Uint64 randomSeed = 1;
+static Uint64 generation = 0;
+
+// columns stepped by each task
+constexpr int COLUMNS_PER_TASK = 16;
+
+// Hensel notation splits each neighbor count up by the shape the neighbors make. this is one
+// arrangement of the live neighbors for each letter, as 8 bits going clockwise from N:
+// N, NE, E, SE, S, SW, W, NW. the rest are rotations and reflections of it.
+// counts 5 to 7 use the same letters as 3 to 1, for the arrangement with live and dead swapped
+struct HenselShape {
+    int count;
+    char letter;
+    const char* cells;
+};
+
+static const HenselShape HENSEL_SHAPES[] = {
+    { 1, 'c', "01000000" }, { 1, 'e', "10000000" },
+
+    { 2, 'c', "01010000" }, { 2, 'e', "10100000" }, { 2, 'k', "10010000" },
+    { 2, 'a', "11000000" }, { 2, 'i', "10001000" }, { 2, 'n', "01000100" },
+
+    { 3, 'c', "01010100" }, { 3, 'e', "10101000" }, { 3, 'k', "10100100" },
+    { 3, 'a', "11100000" }, { 3, 'i', "11000001" }, { 3, 'n', "11010000" },
+    { 3, 'y', "10010100" }, { 3, 'q', "11000100" }, { 3, 'j', "11000010" },
+    { 3, 'r', "11001000" },
+
+    { 4, 'c', "01010101" }, { 4, 'e', "10101010" }, { 4, 'k', "11010010" },
+    { 4, 'a', "11110000" }, { 4, 'i', "11011000" }, { 4, 'n', "11010001" },
+    { 4, 'y', "11010100" }, { 4, 'q', "11100100" }, { 4, 'j', "11001010" },
+    { 4, 'r', "11101000" }, { 4, 't', "11001001" }, { 4, 'w', "11000110" },
+    { 4, 'z', "11001100" },
+};
+
+// every letter used above
+static const char HENSEL_LETTERS[] = "ceaiknjqrytwz";
+
+// the Hensel letter of every arrangement of live neighbors (in the clockwise order above),
+// or 0 for counts 0 and 8, which only have one arrangement
+static char henselLetters[256];
+
+// the bit of the neighborhood index for each neighbor, in the clockwise order above
+static const int NEIGHBOR_BITS[8] = { 1 << 7, 1 << 6, 1 << 3, 1 << 0, 1 << 1, 1 << 2, 1 << 5, 1 << 8 };
+
+// turns a clockwise neighbor arrangement into a neighborhood index
+static int Neighborhood_Index(int neighbors, bool alive)
+{
+    int index = alive ? CENTER_BIT : 0;
+    for (int i = 0; i < 8; i++) {
+        if (neighbors & (0x80 >> i)) index |= NEIGHBOR_BITS[i];
+    }
+    return index;
+}
+
+static int Count_Bits(int bits)
+{
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) count++;
+    return count;
+}
+
+// fills in henselLetters from the shapes, by rotating and reflecting each one
+static void Setup_Hensel_Letters()
+{
+    for (const HenselShape& shape : HENSEL_SHAPES) {
+        int cells = 0;
+        for (int i = 0; i < 8; i++) {
+            if (shape.cells[i] == '1') cells |= 0x80 >> i;
+        }
+
+        for (int reflection = 0; reflection < 2; reflection++) {
+            for (int rotation = 0; rotation < 4; rotation++) {
+                henselLetters[cells] = shape.letter;
+                // the same shape with live and dead swapped, for counts 5 to 7
+                if (shape.count < 4) henselLetters[~cells & 0xff] = shape.letter;
+
+                // a quarter turn clockwise moves every neighbor two places along
+                cells = ((cells >> 2) | (cells << 6)) & 0xff;
+            }
+
+            // mirror left to right: N and S stay put, NE swaps with NW, E with W and SE with SW
+            int mirrored = 0;
+            for (int i = 0; i < 8; i++) {
+                if (cells & (0x80 >> i)) mirrored |= 0x80 >> ((8 - i) % 8);
+            }
+            cells = mirrored;
+        }
+    }
+}
+
+// reads one half of a Hensel rule (the part after B or S), and sets the table entries it covers
+// for cells that are currently alive or dead. returns how many characters were used, or -1
+static int Parse_Hensel_Half(const char* text, bool alive)
+{
+    int used = 0;
+
+    while (text[used] >= '0' && text[used] <= '8') {
+        const int count = text[used] - '0';
+        used++;
+
+        // the letters after the count pick out some of its shapes, or with a '-', all but them
+        const bool negate = text[used] == '-';
+        if (negate) used++;
+
+        const int lettersStart = used;
+        while (text[used] != '\0' && SDL_strchr(HENSEL_LETTERS, text[used]) != NULL) used++;
+        const int letterCount = used - lettersStart;
+
+        if (negate && letterCount == 0) return -1;
+
+        for (int neighbors = 0; neighbors < 256; neighbors++) {
+            if (Count_Bits(neighbors) != count) continue;
+
+            bool listed = letterCount == 0;
+            for (int i = lettersStart; i < used; i++) {
+                if (text[i] == henselLetters[neighbors]) listed = true;
+            }
+            if (negate) listed = !listed;
+
+            if (listed) ruleTable[Neighborhood_Index(neighbors, alive)] = 1;
+        }
+
+        // make sure every letter means something for this count
+        for (int i = lettersStart; i < used; i++) {
+            bool known = false;
+            for (int neighbors = 0; neighbors < 256; neighbors++) {
+                if (Count_Bits(neighbors) == count && henselLetters[neighbors] == text[i]) known = true;
+            }
+            if (!known) return -1;
+        }
+    }
+    return used;
+}
+
+// reads a rule like B3/S23 or B2n3/S23-q. the B and S halves can come in either order
+static bool Parse_Hensel(const char* text)
+{
+    bool seenBirth = false;
+    bool seenSurvival = false;
+
+    int i = 0;
+    while (text[i] != '\0') {
+        const char half = (char)SDL_toupper(text[i]);
+        if (half == 'B' && !seenBirth) seenBirth = true;
+        else if (half == 'S' && !seenSurvival) seenSurvival = true;
+        else return false;
+        i++;
+
+        const int used = Parse_Hensel_Half(text + i, half == 'S');
+        if (used < 0) return false;
+        i += used;
+
+        if (text[i] == '/') i++;
+    }
+    return seenBirth && seenSurvival;
+}
+
+// reads a MAP rule: the 512 table entries as base64, the first character holding the top
+// 6 bits of the first byte, and each byte holding 8 entries starting from its top bit
+static bool Parse_Map(const char* text)
+{
+    static const char DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    int entry = 0;
+    for (int i = 0; text[i] != '\0' && text[i] != '='; i++) {
+        const char* digit = SDL_strchr(DIGITS, text[i]);
+        if (digit == NULL) return false;
+
+        const int value = (int)(digit - DIGITS);
+        for (int bit = 5; bit >= 0 && entry < NEIGHBORHOODS; bit--) {
+            ruleTable[entry++] = (value >> bit) & 1;
+        }
+    }
+    return entry == NEIGHBORHOODS;
+}
+
+// sets the rule from a Hensel rule or MAP string
+// returns false (after logging why) if it can't be read
+bool Parse_Rule(const char* text)
+{
+    Setup_Hensel_Letters();
+    SDL_memset(ruleTable, 0, sizeof(ruleTable));
+
+    const bool parsed = (SDL_strncmp(text, "MAP", 3) == 0) ? Parse_Map(text + 3) : Parse_Hensel(text);
+    if (!parsed) {
+        SDL_Log("Couldn't read the rule %s (it should look like B3/S23, B2n3/S23-q or MAP...)", text);
+        return false;
+    }
+
+    ruleParsed = true;
+    ruleName = text;
+    compiledKernel = NULL;
+    ruleIsLife = true;
+    for (int index = 0; index < NEIGHBORHOODS; index++) {
+        const bool alive = (index & CENTER_BIT) != 0;
+        const int neighbors = Count_Bits(index & ~CENTER_BIT);
+        if (ruleTable[index] != (neighbors == 3 || (neighbors == 2 && alive))) ruleIsLife = false;
+    }
+    return true;
+}
+
+// whether the rule is plain Conway's life (the default), which all the other engines assume
+bool Rule_Is_Life()
+{
+    return ruleIsLife && !stochastic;
+}
+
+// reads the chances of birth and survival, like 0.5,0.99. whatever the rule says is born or
+// survives only does so with that probability
+// returns false (after logging why) if they can't be read
+bool Parse_Rule_Probabilities(const char* text)
+{
+    char* end = NULL;
+    const double birth = SDL_strtod(text, &end);
+    const bool separated = end != text && *end == ',';
+    const char* survivalText = separated ? end + 1 : text;
+    const double survival = SDL_strtod(survivalText, &end);
+
+    if (!separated || end == survivalText || *end != '\0' || birth < 0 || birth > 1 || survival < 0 || survival > 1) {
+        SDL_Log("Couldn't read the probabilities %s (they should look like 0.5,0.99)", text);
+        return false;
+    }
+
+    birthThreshold = (int)(birth * PROBABILITY_ONE + 0.5);
+    survivalThreshold = (int)(survival * PROBABILITY_ONE + 0.5);
+    stochastic = birthThreshold < PROBABILITY_ONE || survivalThreshold < PROBABILITY_ONE;
+
+    // without a rule, the probabilities apply to life
+    if (!ruleParsed && !Parse_Rule("B3/S23")) return false;
+    return true;
+}
+
+// compiles the rule (life, if none was given) into native code, which the rule kernel then steps with
+// returns false (after logging why) if it can't be, in which case the table is used
+bool Rule_Compile()
+{
+    if (!ruleParsed && !Parse_Rule("B3/S23")) return false;
+
+    if (stochastic) {
+        SDL_Log("Stochastic rules can't be compiled, so they use the table kernel");
+        return false;
+    }
+
+    compiledKernel = Jit_Compile_Rule(ruleName.c_str(), ruleTable);
+    return compiledKernel != NULL;
+}
+
+// sets the seed the stochastic rules draw from, and starts again from generation 0
+void Seed_Rule_Random(Uint64 seed)
+{
+    randomSeed = seed;
+    generation = 0;
+}
+
+// the bottom three bits of a neighborhood index, for row y of the three columns
+static inline int Row_Bits(const bool* left, const bool* column, const bool* right, int y)
+{
+    return (left[y] << 2) | (column[y] << 1) | right[y];
+}
+
+// one output of a counter-based generator: the SplitMix64 finalizer applied to key + counter.
+// any word can be made straight from its counter, so it doesn't matter which thread asks first
+static inline uint64_t Random_Word(uint64_t key, uint64_t counter)
+{
+    return Mix_Bits(key + counter * 0x9e3779b97f4a7c15ull);
+}
+
+// 64 independent coin flips that each come up 1 with probability threshold / PROBABILITY_ONE.
+// going from the lowest bit of the threshold to the highest, a 1 bit ORs in a fresh random word
+// (p becomes 1/2 + p/2) and a 0 bit ANDs one in (p becomes p/2), which builds the binary
+// fraction a bit at a time. trailing zero bits would only AND into nothing, so they are skipped
+static uint64_t Bernoulli_Mask(int threshold, uint64_t key, uint64_t counter)
+{
+    if (threshold >= PROBABILITY_ONE) return ~0ull;
+    if (threshold <= 0) return 0;
+
+    int bit = 0;
+    while (((threshold >> bit) & 1) == 0) bit++;
+
+    uint64_t mask = 0;
+    for (; bit < PROBABILITY_BITS; bit++) {
+        const uint64_t random = Random_Word(key, counter * PROBABILITY_BITS + bit);
+        mask = ((threshold >> bit) & 1) ? (mask | random) : (mask & random);
+    }
+    return mask;
+}
+
+// what each task of a step needs to know
+struct RulePass {
+    const bool* current;
+    bool* next;
+    uint64_t key; // the random key for this generation
+};
+
+// the live cells each task found, gathered into the render buffer once they're all done
+struct RuleTask {
+    std::vector<SDL_FPoint> points;
+};
+
+static std::vector<RuleTask> ruleTasks;
+
+// steps cells first to last - 1 of a column with the table
+static void Step_Cells(const bool* left, const bool* column, const bool* right, bool* output, int first, int last)
+{
+    const int up = (first == 0) ? simHeight - 1 : first - 1;
+    int index = (Row_Bits(left, column, right, up) << 3) | Row_Bits(left, column, right, first);
+
+    for (int y = first; y < last; y++) {
+        const int down = (y == simHeight - 1) ? 0 : y + 1;
+        index = ((index << 3) | Row_Bits(left, column, right, down)) & (NEIGHBORHOODS - 1);
+        output[y] = ruleTable[index] != 0;
+    }
+}
+
+// steps a column with the compiled kernel, which does 16 cells at a time between the first and
+// last cells (those two wrap around, so they and anything left over go through the table)
+static void Step_Column_Compiled(const bool* left, const bool* column, const bool* right, bool* output)
+{
+    const int compiledCells = (simHeight - 2) / 16 * 16;
+
+    Step_Cells(left, column, right, output, 0, 1);
+    if (compiledCells > 0) {
+        const JitColumn cells = { left + 1, column + 1, right + 1, output + 1, compiledCells };
+        compiledKernel(&cells);
+    }
+    Step_Cells(left, column, right, output, 1 + compiledCells, simHeight);
+}
+
+// steps COLUMNS_PER_TASK columns
+static void Step_Columns(int task, int worker, void* context)
+{
+    const RulePass& pass = *(const RulePass*)context;
+    std::vector<SDL_FPoint>& points = ruleTasks[task].points;
+    points.clear();
+
+    const int firstColumn = task * COLUMNS_PER_TASK;
+    const int lastColumn = SDL_min(firstColumn + COLUMNS_PER_TASK, simWidth);
+    const uint64_t chunksPerColumn = (uint64_t)(simHeight + 63) / 64;
+
+    for (int x = firstColumn; x < lastColumn; x++) {
+
+        // the three columns of the neighborhood, wrapping around horizontally
+        const bool* left = pass.current + Linear_Index(x == 0 ? simWidth - 1 : x - 1, 0);
+        const bool* column = pass.current + Linear_Index(x, 0);
+        const bool* right = pass.current + Linear_Index(x == simWidth - 1 ? 0 : x + 1, 0);
+        bool* output = pass.next + Linear_Index(x, 0);
+
+        if (compiledKernel != NULL) {
+            Step_Column_Compiled(left, column, right, output);
+
+            For_Each_Live_Byte(output, simHeight, [&](int y) { points.push_back({ (float)x, (float)y }); });
+            continue;
+        }
+
+        // start with the bottom row (wrapping around to above the first cell) and the first row
+        int index = (Row_Bits(left, column, right, simHeight - 1) << 3) | Row_Bits(left, column, right, 0);
+
+        // which of the next 64 cells are allowed to be born or survive if the rule says so
+        uint64_t birthMask = ~0ull;
+        uint64_t survivalMask = ~0ull;
+
+        for (int y = 0; y < simHeight; y++) {
+            if ((y & 63) == 0 && stochastic) {
+                const uint64_t chunk = (uint64_t)x * chunksPerColumn + (uint64_t)(y / 64);
+                birthMask = Bernoulli_Mask(birthThreshold, pass.key, chunk * 2);
+                survivalMask = Bernoulli_Mask(survivalThreshold, pass.key, chunk * 2 + 1);
+            }
+
+            const int down = (y == simHeight - 1) ? 0 : y + 1;
+            index = ((index << 3) | Row_Bits(left, column, right, down)) & (NEIGHBORHOODS - 1);
+
+            const uint64_t allowed = (index & CENTER_BIT) ? survivalMask : birthMask;
+            const bool alive = (ruleTable[index] & (allowed >> (y & 63)) & 1) != 0;
+            output[y] = alive;
+
+            if (alive) points.push_back({ (float)x, (float)y });
+        }
+    }
+    (void)worker;
+}
+
+// steps the whole board from current into next with the rule table (or the compiled kernel), on
+// all the threads, and puts the live cells in renderPoints
+// returns the number of live cells in the next generation
+int Update_Simulation_Rule(const bool* current, bool* next, SDL_FPoint* renderPoints)
+{
+    const int taskCount = (simWidth + COLUMNS_PER_TASK - 1) / COLUMNS_PER_TASK;
+    if ((int)ruleTasks.size() != taskCount) ruleTasks.resize(taskCount);
+
+    RulePass pass = { current, next, Random_Word(randomSeed, generation) };
+    generation++;
+
+    Scheduler_Run(taskCount, Step_Columns, &pass);
+
+    // the tasks are in column order, so the render buffer comes out the same on any number of threads
+    TraceSpan span("gather render points");
+    int population = 0;
+    for (const RuleTask& task : ruleTasks) {
+        if (!task.points.empty()) SDL_memcpy(renderPoints + population, task.points.data(), task.points.size() * sizeof(SDL_FPoint));
+        population += (int)task.points.size();
+    }
+
+    return population;
+}
@@ -0,0 +1,269 @@
+// a work-stealing scheduler for passes over the board (stepping, counting, building render buffers)
+//
+// each pass is a number of independent tasks. Scheduler_Run deals them out to the workers in
+// contiguous blocks (so neighboring tiles stay on the same thread), then every worker pops tasks
+// off the bottom of its own deque and, once that runs dry, steals from the top of a random other
+// worker's deque. a worker with lots of busy tiles gets helped out by the ones whose tiles were
+// quiet. Scheduler_Run returns once every task is done and every worker has left the pass, which
+// is the barrier between generations.
+//
+// the deques are Chase-Lev deques (with the memory orderings from "Correct and Efficient
+// Work-Stealing for Weak Memory Models", Le et al. 2013), so popping, stealing and finishing
+// tasks never take a lock. the only lock is used to park the workers between passes.
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <system_error>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+#include "counters.h"
+#include "scheduler.h"
+#include "trace.h"
+
+// a task number that means "nothing there"
+constexpr int NO_TASK = -1;
+
+// a Chase-Lev deque of task numbers. only the owning worker pushes and pops at the bottom,
+// any worker can steal from the top
+struct TaskDeque {
+    std::atomic<long long> top{ 0 };
+    std::atomic<long long> bottom{ 0 };
+    std::vector<std::atomic<int>> tasks;
+    long long mask = 0;
+
+    // the deque never grows during a pass, so it is sized for the whole pass up front
+    // (only called while the workers are parked)
+    void Reset(int capacity) {
+        size_t size = 16;
+        while ((int)size < capacity) size *= 2;
+        if (tasks.size() < size) tasks = std::vector<std::atomic<int>>(size);
+        mask = (long long)tasks.size() - 1;
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    void Push(int task) {
+        const long long b = bottom.load(std::memory_order_relaxed);
+        tasks[b & mask].store(task, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    int Pop() {
+        const long long b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return NO_TASK;
+        }
+
+        int task = tasks[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // the last task, which a thief might be taking at the same time
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                task = NO_TASK;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    int Steal() {
+        long long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const long long b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) return NO_TASK;
+
+        const int task = tasks[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return NO_TASK; // lost the race to another thief or the owner
+        }
+        return task;
+    }
+};
+
+struct Worker {
+    TaskDeque deque;
+    unsigned int random = 1; // for picking steal victims
+    unsigned long long tasksRun = 0;
+    unsigned long long steals = 0;
+
+    // keeps the next worker's deque off this worker's cache lines
+    char padding[64];
+};
+
+static std::vector<std::unique_ptr<Worker>> workers;
+static std::vector<std::thread> threads;
+
+// the pass currently being run
+static TaskFunction passFunction = nullptr;
+static void* passContext = nullptr;
+static std::atomic<int> tasksLeft{ 0 };
+static std::atomic<int> workersInPass{ 0 };
+
+// parks the workers between passes. passNumber going up is what wakes them
+static std::mutex parkLock;
+static std::condition_variable parkSignal;
+static unsigned long long passNumber = 0;
+static bool stopping = false;
+
+static unsigned long long passes = 0;
+
+// runs tasks until the whole pass is finished
+static void Work(int index) {
+    Worker& self = *workers[index];
+    const int count = (int)workers.size();
+
+    while (tasksLeft.load(std::memory_order_acquire) > 0) {
+        int task = self.deque.Pop();
+
+        // out of work, so try to take some from someone else
+        if (task == NO_TASK && count > 1) {
+            for (int attempt = 0; attempt < count * 2 && task == NO_TASK; attempt++) {
+                self.random ^= self.random << 13;
+                self.random ^= self.random >> 17;
+                self.random ^= self.random << 5;
+
+                const int victim = (int)(self.random % (unsigned int)count);
+                if (victim != index) task = workers[victim]->deque.Steal();
+            }
+            if (task != NO_TASK) self.steals++;
+        }
+
+        if (task == NO_TASK) {
+            // everything left is already being worked on, so wait for it to finish
+            std::this_thread::yield();
+            continue;
+        }
+
+        {
+            TraceSpan span("task", index);
+            passFunction(task, index, passContext);
+        }
+        self.tasksRun++;
+        tasksLeft.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+static void Worker_Thread(int index) {
+    unsigned long long lastPass = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(parkLock);
+            parkSignal.wait(lock, [&] { return stopping || passNumber != lastPass; });
+            if (stopping) return;
+            lastPass = passNumber;
+        }
+
+        Counters_Begin(index);
+        Work(index);
+        Counters_End(index);
+        workersInPass.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+// starts the pool with the given number of workers (including the calling thread)
+// returns false (after logging why, and stopping the threads that did start) if the system won't make that many threads
+bool Scheduler_Start(int count) {
+    if (count < 1) count = 1;
+
+    workers.clear();
+    for (int i = 0; i < count; i++) {
+        workers.emplace_back(new Worker());
+        workers.back()->random = 2463534242u + 7919u * (unsigned int)i;
+    }
+
+    for (int i = 1; i < count; i++) {
+        try {
+            threads.emplace_back(Worker_Thread, i);
+        }
+        catch (const std::system_error& error) {
+            SDL_Log("Couldn't start worker thread %d of %d: %s", i + 1, count, error.what());
+            Scheduler_Stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+// stops and joins the worker threads
+void Scheduler_Stop() {
+    {
+        std::lock_guard<std::mutex> lock(parkLock);
+        stopping = true;
+    }
+    parkSignal.notify_all();
+    for (std::thread& thread : threads) thread.join();
+    threads.clear();
+    stopping = false;
+}
+
+// runs tasks 0 to taskCount - 1 on all the workers, and returns once they have all finished
+void Scheduler_Run(int taskCount, TaskFunction function, void* context) {
+    if (taskCount <= 0) return;
+
+    // no pool (or a single worker), so just run everything here
+    if (workers.size() <= 1) {
+        for (int task = 0; task < taskCount; task++) {
+            TraceSpan span("task");
+            function(task, 0, context);
+        }
+        if (!workers.empty()) workers[0]->tasksRun += taskCount;
+        return;
+    }
+
+    const int count = (int)workers.size();
+
+    // deal the tasks out in contiguous blocks. they are pushed in reverse so each worker
+    // pops its block in order
+    for (int i = 0; i < count; i++) {
+        const int first = (int)((long long)taskCount * i / count);
+        const int last = (int)((long long)taskCount * (i + 1) / count);
+
+        TaskDeque& deque = workers[i]->deque;
+        deque.Reset(taskCount);
+        for (int task = last - 1; task >= first; task--) deque.Push(task);
+    }
+
+    passFunction = function;
+    passContext = context;
+    tasksLeft.store(taskCount, std::memory_order_release);
+    workersInPass.store(count - 1, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(parkLock);
+        passNumber++;
+    }
+    parkSignal.notify_all();
+
+    // this thread is worker 0
+    Work(0);
+
+    // the barrier: every worker has to be out of the pass before the deques get reused
+    while (workersInPass.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    passes++;
+}
+
+// the number of workers, including the thread that calls Scheduler_Run
+int Scheduler_Worker_Count() {
+    return workers.empty() ? 1 : (int)workers.size();
+}
+
+// logs how the work got shared out
+void Scheduler_Log_Stats() {
+    if (workers.size() <= 1) return;
+
+    SDL_Log("scheduler: %llu passes on %d workers", passes, (int)workers.size());
+    for (size_t i = 0; i < workers.size(); i++) {
+        SDL_Log("  worker %d: %llu tasks, %llu stolen", (int)i, workers[i]->tasksRun, workers[i]->steals);
+    }
+}
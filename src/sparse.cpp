@@ -0,0 +1,145 @@
+// the sparse engine only stores the coordinates of live cells, so a step costs O(live cells)
+// instead of O(simWidth * simHeight). it is used automatically when the board is nearly empty
+// (see Choose_Engine in cells.cpp).
+//
+// births are found by hash accumulation: every live cell adds 1 to the neighbor count of each of
+// its 8 neighbors in an open-addressed hash table, and marks its own entry as alive. one pass over
+// the table then applies the rules to every cell that had at least one live neighbor.
+//
+// the dense grid is still kept up to date (only the cells that were or became alive are written),
+// so painting, rendering and switching back to the dense engine all keep working unchanged.
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "cells.h"
+#include "sparse.h"
+
+// marks an unused slot in the hash table. real keys never have the top bit set
+constexpr uint64_t EMPTY_KEY = ~0ull;
+
+// the live cells, packed as (x << 32) | y
+static std::vector<uint64_t> liveCells;
+
+// scratch list for building the next generation
+static std::vector<uint64_t> nextLiveCells;
+
+// the open-addressed hash table used to accumulate neighbor counts
+// each value holds (neighbor count * 2) + 1 if the cell itself is alive
+static std::vector<uint64_t> tableKeys;
+static std::vector<uint8_t> tableValues;
+static uint64_t tableMask = 0;
+
+static inline uint64_t Pack_Cell(int x, int y) {
+    return ((uint64_t)x << 32) | (uint32_t)y;
+}
+
+// finds (or claims) the slot for the given key, using linear probing
+static inline uint64_t Find_Slot(uint64_t key) {
+    // fibonacci hashing spreads neighboring coordinates across the table
+    uint64_t slot = (key * 0x9E3779B97F4A7C15ull) >> 20;
+    while (true) {
+        slot &= tableMask;
+        if (tableKeys[slot] == key) return slot;
+        if (tableKeys[slot] == EMPTY_KEY) {
+            tableKeys[slot] = key;
+            return slot;
+        }
+        slot++;
+    }
+}
+
+// makes the table big enough to hold every cell touched by the current live cells,
+// at no more than 50% load, and empties it
+static void Prepare_Table() {
+    const size_t touched = liveCells.size() * 9;
+    size_t capacity = 64;
+    while (capacity < touched * 2) capacity *= 2;
+
+    if (tableKeys.size() != capacity) {
+        tableKeys.assign(capacity, EMPTY_KEY);
+        tableValues.assign(capacity, 0);
+    }
+    else {
+        std::fill(tableKeys.begin(), tableKeys.end(), EMPTY_KEY);
+        std::fill(tableValues.begin(), tableValues.end(), 0);
+    }
+    tableMask = capacity - 1;
+}
+
+// rebuilds the live cell list from the dense grid
+// this is O(simWidth * simHeight), but only happens when switching engines
+void Sparse_Load_From_Grid() {
+    liveCells.clear();
+    for (int x = 0; x < simWidth; x++) {
+        for (int y = 0; y < simHeight; y++) {
+            if (Get_Cell(x, y)) liveCells.push_back(Pack_Cell(x, y));
+        }
+    }
+}
+
+// adds a newly painted cell to the live list
+// the caller makes sure the cell wasn't already alive
+void Sparse_Add_Cell(int x, int y) {
+    liveCells.push_back(Pack_Cell(x, y));
+}
+
+// the number of live cells
+int Sparse_Population() {
+    return (int)liveCells.size();
+}
+
+// steps the simulation using only the live cells
+void Sparse_Update_Simulation() {
+    Prepare_Table();
+
+    // every live cell contributes to its 8 neighbors, wrapping around on both axes
+    for (uint64_t cell : liveCells) {
+        const int x = (int)(cell >> 32);
+        const int y = (int)(uint32_t)cell;
+
+        tableValues[Find_Slot(cell)] |= 1;
+
+        for (int dx = -1; dx <= 1; dx++) {
+            int nx = x + dx;
+            if (nx < 0) nx = simWidth - 1;
+            if (nx == simWidth) nx = 0;
+
+            for (int dy = -1; dy <= 1; dy++) {
+                if (dx == 0 && dy == 0) continue;
+
+                int ny = y + dy;
+                if (ny < 0) ny = simHeight - 1;
+                if (ny == simHeight) ny = 0;
+
+                tableValues[Find_Slot(Pack_Cell(nx, ny))] += 2;
+            }
+        }
+    }
+
+    // apply the rules to every cell that was touched
+    nextLiveCells.clear();
+    for (size_t slot = 0; slot < tableKeys.size(); slot++) {
+        if (tableKeys[slot] == EMPTY_KEY) continue;
+
+        const int neighbors = tableValues[slot] >> 1;
+        const bool alive = tableValues[slot] & 1;
+
+        if (neighbors == 3 || (alive && neighbors == 2)) nextLiveCells.push_back(tableKeys[slot]);
+    }
+
+    // write the changes back to the dense grid and the render buffer
+    // only cells that were alive last step or are alive now are touched
+    Clear_Rendered_Points();
+    for (uint64_t cell : liveCells) {
+        Set_Cell((int)(cell >> 32), (int)(uint32_t)cell, false);
+    }
+    for (uint64_t cell : nextLiveCells) {
+        const int x = (int)(cell >> 32);
+        const int y = (int)(uint32_t)cell;
+        Set_Cell(x, y, true);
+        Add_Rendered_Point(x, y);
+    }
+
+    liveCells.swap(nextLiveCells);
+}
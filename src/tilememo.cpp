@@ -0,0 +1,205 @@
+// the tile memo engine splits the board into 16x16 tiles. the next generation of a tile only
+// depends on the tile and the 1-cell border around it, so each 18x18 neighborhood is packed into
+// bits and looked up in a memo table. only neighborhoods that haven't been seen recently are
+// actually computed. boards full of ash (blocks, blinkers, beehives...) repeat the same few
+// neighborhoods over and over, so most tiles become a hash and a table lookup.
+//
+// the memo table has a fixed size. it is set-associative: each neighborhood can only live in the
+// MEMO_WAYS slots of the set its hash picks, and a miss evicts the least recently used slot of
+// that set. this keeps lookups O(1) with no allocation, at the cost of being LRU per set rather
+// than across the whole table.
+
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <cstring>
+#include "cells.h"
+#include "tilememo.h"
+#include "alloc.h"
+
+constexpr int TILE_SIZE = 16;
+constexpr int BORDERED_SIZE = TILE_SIZE + 2;
+
+// the memo table holds MEMO_SETS * MEMO_WAYS tiles (about 5 MB)
+constexpr int MEMO_SETS = 1 << 14;
+constexpr int MEMO_WAYS = 4;
+
+// a bordered tile, packed as 18 lines of 18 bits, 3 lines per word
+constexpr int KEY_WORDS = 6;
+
+// the next generation of a tile's interior, packed as 16 lines of 16 bits, 4 lines per word
+constexpr int RESULT_WORDS = 4;
+
+struct MemoEntry {
+    uint64_t key[KEY_WORDS];
+    uint64_t result[RESULT_WORDS];
+    uint32_t lastUsed; // 0 means the slot is empty
+};
+
+static MemoEntry* memoTable = nullptr;
+
+// counts up every lookup, so the least recently used slot has the smallest lastUsed
+static uint32_t memoClock = 0;
+
+static uint64_t memoHits = 0;
+static uint64_t memoMisses = 0;
+static uint64_t emptyTiles = 0;
+
+static int tilePopulation = 0;
+
+// gets line i of a packed bordered tile
+static inline uint32_t Key_Line(const uint64_t* key, int i) {
+    return (uint32_t)(key[i / 3] >> (18 * (i % 3))) & 0x3FFFF;
+}
+
+// packs the tile whose top-left corner is tx,ty and its border
+// a line runs along y (matching how the grid is stored), with bit 0 holding ty - 1
+static void Gather_Tile(int tx, int ty, uint64_t* key) {
+    std::memset(key, 0, sizeof(uint64_t) * KEY_WORDS);
+
+    for (int i = 0; i < BORDERED_SIZE; i++) {
+
+        // the board wraps around, so the border can come from the other side
+        // (more than once round, on boards narrower than a tile)
+        const int x = ((tx + i - 1) % simWidth + simWidth) % simWidth;
+
+        uint64_t line = 0;
+        for (int j = 0; j < BORDERED_SIZE; j++) {
+            const int y = ((ty + j - 1) % simHeight + simHeight) % simHeight;
+
+            if (Get_Cell(x, y)) line |= 1ull << j;
+        }
+        key[i / 3] |= line << (18 * (i % 3));
+    }
+}
+
+// computes the next generation of a tile's interior from its bordered lines,
+// all 16 cells of a line at once using bitwise adders
+static void Compute_Tile(const uint64_t* key, uint64_t* result) {
+    std::memset(result, 0, sizeof(uint64_t) * RESULT_WORDS);
+
+    for (int i = 1; i <= TILE_SIZE; i++) {
+        const uint32_t left = Key_Line(key, i - 1);
+        const uint32_t line = Key_Line(key, i);
+        const uint32_t right = Key_Line(key, i + 1);
+
+        // add up the three cells of each neighboring line that touch each cell of this line
+        const uint32_t leftOnes = (left >> 1) ^ left ^ (left << 1);
+        const uint32_t leftTwos = ((left >> 1) & left) | ((left << 1) & ((left >> 1) ^ left));
+        const uint32_t midOnes = (line >> 1) ^ (line << 1);
+        const uint32_t midTwos = (line >> 1) & (line << 1);
+        const uint32_t rightOnes = (right >> 1) ^ right ^ (right << 1);
+        const uint32_t rightTwos = ((right >> 1) & right) | ((right << 1) & ((right >> 1) ^ right));
+
+        // the count is ones + 2 * (number of twos set), so a cell with 2 or 3 neighbors has
+        // exactly one of the twos set
+        const uint32_t ones = leftOnes ^ midOnes ^ rightOnes;
+        const uint32_t onesCarry = (leftOnes & midOnes) | (rightOnes & (leftOnes ^ midOnes));
+        const uint32_t exactlyOneTwo = ((leftTwos ^ midTwos) ^ (rightTwos ^ onesCarry))
+            & ~((leftTwos & midTwos) | (rightTwos & onesCarry));
+
+        // born with 3 neighbors, survives with 2 or 3. bits 1-16 are the interior
+        const uint32_t next = (exactlyOneTwo & (ones | line)) >> 1;
+
+        const int out = i - 1;
+        result[out / 4] |= (uint64_t)(next & 0xFFFF) << (16 * (out % 4));
+    }
+}
+
+// makes room for the memo table
+// returns false if there isn't room
+bool Tile_Memo_Allocate() {
+    if (memoTable == nullptr) {
+        memoTable = (MemoEntry*)Allocate_Buffer(sizeof(MemoEntry) * MEMO_SETS * MEMO_WAYS, "tile memo");
+    }
+    return memoTable != nullptr;
+}
+
+// finds a tile's next generation in the memo table, computing and storing it on a miss
+static const uint64_t* Lookup_Tile(const uint64_t* key) {
+    if (memoTable == nullptr) Tile_Memo_Allocate();
+
+    uint64_t hash = 0;
+    for (int i = 0; i < KEY_WORDS; i++) {
+        hash = (hash ^ key[i]) * 0x9E3779B97F4A7C15ull;
+    }
+    hash ^= hash >> 29;
+
+    MemoEntry* set = &memoTable[(size_t)(hash & (MEMO_SETS - 1)) * MEMO_WAYS];
+    memoClock++;
+
+    MemoEntry* oldest = &set[0];
+    for (int way = 0; way < MEMO_WAYS; way++) {
+        MemoEntry& entry = set[way];
+        if (entry.lastUsed != 0 && std::memcmp(entry.key, key, sizeof(entry.key)) == 0) {
+            entry.lastUsed = memoClock;
+            memoHits++;
+            return entry.result;
+        }
+        if (entry.lastUsed < oldest->lastUsed) oldest = &entry;
+    }
+
+    memoMisses++;
+    std::memcpy(oldest->key, key, sizeof(oldest->key));
+    Compute_Tile(key, oldest->result);
+    oldest->lastUsed = memoClock;
+    return oldest->result;
+}
+
+// steps the simulation a tile at a time, only computing tiles that aren't in the memo table
+void Tile_Memo_Update_Simulation() {
+    uint64_t key[KEY_WORDS];
+    static const uint64_t emptyResult[RESULT_WORDS] = {};
+
+    Clear_Rendered_Points();
+    tilePopulation = 0;
+
+    // the clock is only 32 bits, so start afresh rather than let it wrap around
+    if (memoClock > 0xF0000000u) {
+        std::memset(memoTable, 0, sizeof(MemoEntry) * MEMO_SETS * MEMO_WAYS);
+        memoClock = 0;
+    }
+
+    for (int tx = 0; tx < simWidth; tx += TILE_SIZE) {
+        for (int ty = 0; ty < simHeight; ty += TILE_SIZE) {
+            Gather_Tile(tx, ty, key);
+
+            // empty neighborhoods are by far the most common, so they skip the table entirely
+            const uint64_t* result = emptyResult;
+            if ((key[0] | key[1] | key[2] | key[3] | key[4] | key[5]) != 0) result = Lookup_Tile(key);
+            else emptyTiles++;
+
+            // tiles on the right and bottom edges can be cut short by the edge of the board
+            const int width = SDL_min(TILE_SIZE, simWidth - tx);
+            const int height = SDL_min(TILE_SIZE, simHeight - ty);
+
+            for (int i = 0; i < width; i++) {
+                const uint32_t line = (uint32_t)(result[i / 4] >> (16 * (i % 4))) & 0xFFFF;
+                for (int j = 0; j < height; j++) {
+                    const bool alive = (line >> j) & 1;
+                    Set_Next_Cell(tx + i, ty + j, alive);
+                    if (alive) {
+                        tilePopulation++;
+                        Add_Rendered_Point(tx + i, ty + j);
+                    }
+                }
+            }
+        }
+    }
+
+    Swap_States();
+}
+
+// the number of live cells after the last step
+int Tile_Memo_Population() {
+    return tilePopulation;
+}
+
+// logs how well the memo table did
+void Tile_Memo_Log_Stats() {
+    const uint64_t lookups = memoHits + memoMisses;
+    if (lookups + emptyTiles == 0) return;
+
+    SDL_Log("tile memo: %llu empty tiles, %llu lookups, %.1f%% hit rate",
+        (unsigned long long)emptyTiles, (unsigned long long)lookups,
+        lookups ? 100.0 * (double)memoHits / (double)lookups : 0.0);
+}
@@ -0,0 +1,94 @@
+// records spans of the frame (painting, stepping, building the render buffer, drawing, presenting)
+// and the tasks each worker runs, and writes them out in the chrome trace event format, which
+// chrome://tracing and ui.perfetto.dev both open. each worker gets its own track, so it shows how
+// the phases of a frame line up and where the threads sit idle.
+//
+// every worker appends to its own list of spans, so recording never takes a lock. the lists are
+// turned into JSON when tracing is switched off and on exit, and the file always holds everything
+// recorded so far.
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include "trace.h"
+
+// stops a forgotten trace from eating all the memory: about 24 MB per worker
+constexpr size_t MAX_SPANS_PER_WORKER = 1 << 20;
+
+struct TraceEvent {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+};
+
+bool traceEnabled = false;
+
+static const char* traceFile = "cells-trace.json";
+static std::vector<std::vector<TraceEvent>> spans;
+static Uint64 traceStart = 0; // spans are timed from here
+static bool full = false;
+
+// sets where the trace goes and how many workers it has tracks for, and starts recording if a
+// file was given (otherwise it waits for Trace_Toggle)
+void Trace_Setup(const char* file, int workerCount)
+{
+    spans.assign(SDL_max(workerCount, 1), std::vector<TraceEvent>());
+    traceStart = SDL_GetPerformanceCounter();
+    if (file != NULL) {
+        traceFile = file;
+        traceEnabled = true;
+    }
+}
+
+// starts or stops recording. stopping writes out the file, so it can be looked at straight away
+void Trace_Toggle()
+{
+    if (spans.empty()) return;
+
+    traceEnabled = !traceEnabled;
+    if (traceEnabled) SDL_Log("tracing to %s", traceFile);
+    else Trace_Write();
+}
+
+// records a span on the given worker's track
+void Trace_Add(const char* name, int worker, Uint64 start, Uint64 end)
+{
+    std::vector<TraceEvent>& list = spans[worker];
+    if (list.size() >= MAX_SPANS_PER_WORKER) {
+        full = true;
+        return;
+    }
+    list.push_back({ name, start, end });
+}
+
+// writes every span recorded so far
+void Trace_Write()
+{
+    size_t spanCount = 0;
+    for (const std::vector<TraceEvent>& list : spans) spanCount += list.size();
+    if (spanCount == 0) return;
+
+    SDL_IOStream* file = SDL_IOFromFile(traceFile, "w");
+    if (file == NULL) {
+        SDL_Log("Couldn't write the trace to %s: %s", traceFile, SDL_GetError());
+        return;
+    }
+
+    // timestamps are in microseconds
+    const double toMicroseconds = 1e6 / (double)SDL_GetPerformanceFrequency();
+
+    SDL_IOprintf(file, "{\"traceEvents\":[\n");
+    SDL_IOprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"cells\"}}");
+    for (size_t w = 0; w < spans.size(); w++) {
+        if (w == 0) SDL_IOprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}");
+        else SDL_IOprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", (int)w, (int)w);
+
+        for (const TraceEvent& span : spans[w]) {
+            SDL_IOprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", span.name, (int)w,
+                (double)(span.start - traceStart) * toMicroseconds, (double)(span.end - span.start) * toMicroseconds);
+        }
+    }
+    SDL_IOprintf(file, "\n]}\n");
+    SDL_CloseIO(file);
+
+    SDL_Log("wrote %llu spans to %s%s", (unsigned long long)spanCount, traceFile, full ? " (some workers ran out of room)" : "");
+}
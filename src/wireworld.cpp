@@ -0,0 +1,224 @@
+// Wireworld, with its own four-state grid: empty, electron head, electron tail and copper
+//
+// each step, heads become tails, tails become copper, and copper becomes a head if one or two of
+// its neighbors are heads. in a circuit nearly all of the board is copper or empty and stays that
+// way, so only the electrons are kept in lists. a step visits the neighbors of each head to count
+// them up on the copper around it, and never looks at the rest of the board, so it costs the
+// same on a huge circuit as on a small one with the same number of signals in flight.
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include <cstdint>
+#include "cells.h"
+#include "layout.h"
+#include "alloc.h"
+#include "wireworld.h"
+
+enum WireState : uint8_t {
+    WIRE_EMPTY,
+    WIRE_HEAD,
+    WIRE_TAIL,
+    WIRE_COPPER
+};
+
+// the state of every cell, found with Cell_Index
+static uint8_t* wireCells = NULL;
+
+// how many heads are next to each copper cell, only nonzero partway through a step
+static uint8_t* headCounts = NULL;
+
+// the cells in each state. wire holds everything that isn't empty, since nothing is ever
+// turned back into an empty cell
+static std::vector<SDL_Point> heads;
+static std::vector<SDL_Point> tails;
+static std::vector<SDL_Point> wire;
+
+// the copper cells next to at least one head, during a step
+static std::vector<SDL_Point> candidates;
+
+// makes room for the board, once its size is known
+// returns false if there isn't room
+bool Wireworld_Allocate()
+{
+    const size_t cells = Grid_Cell_Count();
+    wireCells = (uint8_t*)Allocate_Buffer(cells, "wire cells");
+    headCounts = (uint8_t*)Allocate_Buffer(cells, "wire head counts");
+    return wireCells != NULL && headCounts != NULL;
+}
+
+// sets a single cell, keeping the lists up to date
+static void Set_Wire(int x, int y, WireState state)
+{
+    uint8_t& cell = wireCells[Cell_Index(x, y)];
+    if (cell == state || state == WIRE_EMPTY) return;
+
+    if (cell == WIRE_EMPTY) wire.push_back({ x, y });
+
+    // an electron being painted over has to come out of its list
+    if (cell == WIRE_HEAD || cell == WIRE_TAIL) {
+        std::vector<SDL_Point>* list = (cell == WIRE_HEAD) ? &heads : &tails;
+        for (size_t i = 0; i < list->size(); i++) {
+            if ((*list)[i].x == x && (*list)[i].y == y) {
+                (*list)[i] = list->back();
+                list->pop_back();
+                break;
+            }
+        }
+    }
+
+    cell = state;
+    if (state == WIRE_HEAD) heads.push_back({ x, y });
+    if (state == WIRE_TAIL) tails.push_back({ x, y });
+}
+
+// paints copper onto an empty cell, or an electron head onto copper
+void Wireworld_Paint(int x, int y, bool electron)
+{
+    const uint8_t cell = wireCells[Cell_Index(x, y)];
+
+    if (electron && cell == WIRE_COPPER) Set_Wire(x, y, WIRE_HEAD);
+    else if (!electron && cell == WIRE_EMPTY) Set_Wire(x, y, WIRE_COPPER);
+    else return;
+
+    Request_Redraw();
+}
+
+// loads a Wireworld pattern in Golly's RLE format (. is empty, A a head, B a tail and C copper)
+// into the top-left of the board. returns false (after logging why) if it can't
+bool Wireworld_Load(const char* path)
+{
+    size_t size;
+    char* text = (char*)SDL_LoadFile(path, &size);
+    if (text == NULL) {
+        SDL_Log("Couldn't open %s: %s", path, SDL_GetError());
+        return false;
+    }
+
+    int x = 0;
+    int y = 0;
+    int run = 0;
+    bool ok = true;
+    bool headerRead = false;
+
+    for (size_t i = 0; i < size && ok; i++) {
+        const char c = text[i];
+
+        // comment lines and the x = ..., y = ... header
+        if (run == 0 && (c == '#' || (c == 'x' && !headerRead))) {
+            if (c == 'x') {
+                int width, height;
+                if (SDL_sscanf(text + i, "x = %d , y = %d", &width, &height) == 2 && (width > simWidth || height > simHeight)) {
+                    SDL_Log("%s is %dx%d, which doesn't fit on the board (use --size)", path, width, height);
+                    ok = false;
+                }
+                headerRead = true;
+            }
+            while (i < size && text[i] != '\n') i++;
+            continue;
+        }
+
+        if (c >= '0' && c <= '9') {
+            run = run * 10 + (c - '0');
+            continue;
+        }
+
+        const int count = SDL_max(run, 1);
+        run = 0;
+
+        if (c == '!') break;
+        else if (c == '$') {
+            x = 0;
+            y += count;
+        }
+        else if (c == '.' || c == 'b' || c == 'A' || c == 'B' || c == 'C' || c == 'o') {
+            // plain life patterns (b and o) load as copper
+            const WireState state = (c == 'A') ? WIRE_HEAD : (c == 'B') ? WIRE_TAIL : (c == 'C' || c == 'o') ? WIRE_COPPER : WIRE_EMPTY;
+
+            if (x + count > simWidth || y >= simHeight) {
+                SDL_Log("%s doesn't fit on the board (use --size)", path);
+                ok = false;
+                break;
+            }
+            for (int j = 0; j < count; j++) Set_Wire(x + j, y, state);
+            x += count;
+        }
+        else if (c != ' ' && c != '\r' && c != '\n' && c != '\t') {
+            SDL_Log("Unexpected '%c' in %s", c, path);
+            ok = false;
+        }
+    }
+
+    SDL_free(text);
+    Request_Redraw();
+    return ok;
+}
+
+// steps the board a generation
+void Wireworld_Update_Simulation()
+{
+    // count the heads next to each copper cell, remembering which cells got counted
+    for (const SDL_Point& head : heads) {
+        for (int dx = -1; dx <= 1; dx++) {
+            const int nx = (head.x + dx + simWidth) % simWidth;
+            for (int dy = -1; dy <= 1; dy++) {
+                const int ny = (head.y + dy + simHeight) % simHeight;
+
+                const size_t index = Cell_Index(nx, ny);
+                if (wireCells[index] == WIRE_COPPER && headCounts[index]++ == 0) {
+                    candidates.push_back({ nx, ny });
+                }
+            }
+        }
+    }
+
+    // tails turn back into copper, and heads into tails
+    for (const SDL_Point& tail : tails) wireCells[Cell_Index(tail.x, tail.y)] = WIRE_COPPER;
+    for (const SDL_Point& head : heads) wireCells[Cell_Index(head.x, head.y)] = WIRE_TAIL;
+    tails.swap(heads);
+    heads.clear();
+
+    // copper next to one or two heads becomes a head
+    for (const SDL_Point& cell : candidates) {
+        const size_t index = Cell_Index(cell.x, cell.y);
+        if (headCounts[index] <= 2) {
+            wireCells[index] = WIRE_HEAD;
+            heads.push_back(cell);
+        }
+        headCounts[index] = 0;
+    }
+    candidates.clear();
+
+    Request_Redraw();
+}
+
+// the number of electron heads on the board
+int Wireworld_Population()
+{
+    return (int)heads.size();
+}
+
+// a hash of the state of every cell
+Uint64 Wireworld_Hash()
+{
+    return Hash_Bytes(wireCells, Grid_Cell_Count());
+}
+
+// draws a list of cells in the given color
+static void Render_Cells(SDL_Renderer* renderer, const std::vector<SDL_Point>& cells, Uint8 r, Uint8 g, Uint8 b)
+{
+    static std::vector<SDL_FPoint> points;
+
+    points.clear();
+    for (const SDL_Point& cell : cells) points.push_back({ (float)cell.x, (float)cell.y });
+
+    SDL_SetRenderDrawColor(renderer, r, g, b, SDL_ALPHA_OPAQUE);
+    SDL_RenderPoints(renderer, points.data(), (int)points.size());
+}
+
+// draws the wire in yellow, then the electron heads in blue and the tails in red on top of it
+void Wireworld_Render(SDL_Renderer* renderer)
+{
+    Render_Cells(renderer, wire, 255, 200, 0);
+    Render_Cells(renderer, heads, 0, 128, 255);
+    Render_Cells(renderer, tails, 255, 64, 0);
+}